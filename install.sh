@@ -504,7 +504,7 @@ compile_daemons_and_tools() {
             
             if execute make clean all; then
                 log_success "Successfully compiled all C++ daemons."
-                execute cp build/* "$USER_BIN_DIR/" || log_warn "Failed to copy binaries to $USER_BIN_DIR"
+                execute find build -maxdepth 1 -type f -executable -exec cp {} "$USER_BIN_DIR/" \; || log_warn "Failed to copy binaries to $USER_BIN_DIR"
             else
                 log_error "Compilation failed. Check the output above."
             fi
@@ -0,0 +1,177 @@
+// Measures field extraction from j/clients replies: the substring helpers
+// hypr-nice used, a full nlohmann DOM as navbar-watcher built, and
+// JsonReader. The DOM variant is left out when nlohmann/json is not
+// installed. Each pass pulls pid, address and workspace.id out of every
+// client, which is all the daemons need from a resync.
+#include <chrono>
+#include <cctype>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <string>
+#include <string_view>
+#if __has_include(<nlohmann/json.hpp>)
+#include <nlohmann/json.hpp>
+#define HAVE_NLOHMANN_JSON 1
+#endif
+#include "json-reader.hpp"
+
+// Shaped like a Hyprland 0.4x client entry, titles with escapes included.
+std::string make_clients(size_t count) {
+    std::string reply = "[";
+    for (size_t i = 0; i < count; ++i) {
+        char entry[1024];
+        snprintf(entry, sizeof(entry),
+            "%s{\n    \"address\": \"0x55d1c2%06zx\",\n    \"mapped\": true,\n    \"hidden\": false,\n"
+            "    \"at\": [%zu, 40],\n    \"size\": [1268, 1002],\n"
+            "    \"workspace\": {\n        \"id\": %zu,\n        \"name\": \"%zu\"\n    },\n"
+            "    \"floating\": false,\n    \"pseudo\": false,\n    \"monitor\": 0,\n"
+            "    \"class\": \"kitty\",\n    \"title\": \"~/src/NeKoRoSHELL: make -j8 \\\"all\\\" {%zu}\",\n"
+            "    \"initialClass\": \"kitty\",\n    \"initialTitle\": \"kitty\",\n    \"pid\": %zu,\n"
+            "    \"xwayland\": false,\n    \"pinned\": false,\n    \"fullscreen\": 0,\n"
+            "    \"fullscreenClient\": 0,\n    \"grouped\": [],\n    \"tags\": [],\n"
+            "    \"swallowing\": \"0x0\",\n    \"focusHistoryID\": %zu,\n    \"inhibitingIdle\": false\n}",
+            i ? "," : "", i, i * 16, (i % 10) + 1, (i % 10) + 1, i, 1000 + i, i);
+        reply += entry;
+    }
+    reply += "]";
+    return reply;
+}
+
+struct Totals {
+    uint64_t pids = 0;
+    uint64_t addresses = 0;
+    int64_t workspaces = 0;
+};
+
+// get_json_int(), get_json_string() and for_each_json_object() as hypr-nice
+// shipped them before JsonReader, copied verbatim.
+int get_json_int(const std::string& json, const std::string& key, size_t from = 0) {
+    std::string search = "\"" + key + "\":";
+    size_t pos = json.find(search, from);
+    if (pos == std::string::npos) return -999;
+    
+    size_t start = pos + search.length();
+    while (start < json.length() && (json[start] == ' ' || json[start] == '\n')) start++;
+    
+    size_t end = start;
+    while (end < json.length() && (isdigit(json[end]) || json[end] == '-')) end++;
+    
+    try {
+        return std::stoi(json.substr(start, end - start));
+    } catch (...) {
+        return -999;
+    }
+}
+
+std::string get_json_string(const std::string& json, const std::string& key) {
+    std::string search = "\"" + key + "\":";
+    size_t pos = json.find(search);
+    if (pos == std::string::npos) return "";
+
+    size_t start = json.find('"', pos + search.length());
+    if (start == std::string::npos) return "";
+
+    std::string value;
+    for (size_t i = start + 1; i < json.length() && json[i] != '"'; ++i) {
+        if (json[i] == '\\' && i + 1 < json.length()) i++;
+        value += json[i];
+    }
+    return value;
+}
+
+// Calls fn on every top-level object of a JSON array reply, skipping over
+// braces that appear inside strings (window titles can contain them).
+template <typename Fn>
+void for_each_json_object(const std::string& json, Fn fn) {
+    size_t cursor = 0;
+    while ((cursor = json.find('{', cursor)) != std::string::npos) {
+        int depth = 1;
+        bool in_string = false;
+        size_t end = cursor + 1;
+        while (end < json.length() && depth > 0) {
+            char c = json[end];
+            if (in_string) {
+                if (c == '\\') end++;
+                else if (c == '"') in_string = false;
+            }
+            else if (c == '"') in_string = true;
+            else if (c == '{') depth++;
+            else if (c == '}') depth--;
+            end++;
+        }
+        fn(json.substr(cursor, end - cursor));
+        cursor = end;
+    }
+}
+
+// Same lookups as hypr-nice's old ClientTable::load_clients().
+void legacy(const std::string& reply, Totals& totals) {
+    for_each_json_object(reply, [&totals](const std::string& obj) {
+        totals.addresses += get_json_string(obj, "address").size();
+        totals.pids += get_json_int(obj, "pid");
+        size_t ws_block_pos = obj.find("\"workspace\":");
+        int ws_id = (ws_block_pos != std::string::npos) ? get_json_int(obj, "id", ws_block_pos) : -999;
+        totals.workspaces += ws_id;
+    });
+}
+
+#ifdef HAVE_NLOHMANN_JSON
+void dom(const std::string& reply, Totals& totals) {
+    auto clients = nlohmann::json::parse(reply);
+    for (const auto& client : clients) {
+        totals.addresses += client["address"].get<std::string>().size();
+        totals.pids += client["pid"].get<int>();
+        totals.workspaces += client["workspace"]["id"].get<int>();
+    }
+}
+#endif
+
+void reader(const std::string& reply, Totals& totals) {
+    JsonReader json(reply);
+    if (!json.enter_array()) return;
+    while (json.next_element()) {
+        if (!json.enter_object()) continue;
+        std::string_view key, address;
+        int pid = 0, ws = 0;
+        while (json.next_member(key)) {
+            if (key == "address") json.read_string(address);
+            else if (key == "pid") json.read_int(pid);
+            else if (key == "workspace") json.read_member_int("id", ws);
+            else json.skip();
+        }
+        totals.addresses += address.size();
+        totals.pids += pid;
+        totals.workspaces += ws;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    size_t passes = (argc > 1) ? strtoul(argv[1], nullptr, 10) : 2000;
+
+    struct Variant {
+        const char* name;
+        std::function<void(const std::string&, Totals&)> run;
+    } variants[] = {
+        {"substring helpers", legacy},
+#ifdef HAVE_NLOHMANN_JSON
+        {"nlohmann DOM", dom},
+#endif
+        {"JsonReader", reader},
+    };
+
+    for (size_t count : {10, 100, 500}) {
+        std::string reply = make_clients(count);
+        printf("%zu clients, %.1f KiB reply\n", count, reply.size() / 1024.0);
+        for (const Variant& variant : variants) {
+            Totals totals;
+            auto start = std::chrono::steady_clock::now();
+            for (size_t i = 0; i < passes; ++i) variant.run(reply, totals);
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            printf("  %-20s %10.1f us/reply  (checksum %llu)\n", variant.name, seconds * 1e6 / passes,
+                   (unsigned long long)(totals.pids + totals.addresses + totals.workspaces));
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,123 @@
+// Measures socket2 framing throughput: the old append/substr/erase loop used
+// by the daemons versus LineReader. Events go through a non-blocking
+// socketpair in bursts, the way Hyprland delivers them during a workspace
+// storm or session restore.
+#include <chrono>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <vector>
+#include "line-reader.hpp"
+
+std::string make_events(size_t count) {
+    static const char* samples[] = {
+        "workspacev2>>3,3",
+        "focusedmonv2>>DP-1,3",
+        "activewindowv2>>55d1c2a0b7f0",
+        "openwindow>>55d1c2a0b7f0,3,kitty,~/src/NeKoRoSHELL: make",
+        "windowtitlev2>>55d1c2a0b7f0,~/src/NeKoRoSHELL: make -j8 all && ./build/hypr-nice --cgroup",
+        "movewindowv2>>55d1c2a0b7f0,4,4",
+        "closewindow>>55d1c2a0b7f0",
+        "openlayer>>waybar",
+    };
+    std::string data;
+    for (size_t i = 0; i < count; ++i) {
+        data += samples[i % (sizeof(samples) / sizeof(samples[0]))];
+        data += '\n';
+    }
+    return data;
+}
+
+// Reader callback: drains the socket, returns false on EOF or error.
+using Drain = std::function<bool(int fd, size_t& lines, size_t& bytes)>;
+
+double run(const std::string& data, const Drain& drain, size_t& lines) {
+    int fds[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, fds) == -1) {
+        perror("socketpair");
+        exit(1);
+    }
+
+    size_t bytes = 0;
+    size_t offset = 0;
+    lines = 0;
+    auto start = std::chrono::steady_clock::now();
+    while (offset < data.size()) {
+        ssize_t written = write(fds[1], data.data() + offset, data.size() - offset);
+        if (written > 0) offset += written;
+        drain(fds[0], lines, bytes);
+    }
+    close(fds[1]);
+    while (drain(fds[0], lines, bytes)) {}
+    auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    close(fds[0]);
+    if (bytes == 0) fprintf(stderr, "no data\n");
+    return elapsed;
+}
+
+Drain legacy_reader(size_t buffer_size) {
+    auto pending_data = std::make_shared<std::string>();
+    auto buffer_storage = std::make_shared<std::vector<char>>(buffer_size);
+    return [pending_data, buffer_storage](int fd, size_t& lines, size_t& bytes) {
+        std::vector<char>& buffer = *buffer_storage;
+        while (true) {
+            ssize_t num_read = read(fd, buffer.data(), buffer.size() - 1);
+            if (num_read <= 0) return num_read == -1 && errno == EAGAIN;
+            buffer[num_read] = '\0';
+            *pending_data += buffer.data();
+
+            size_t pos = 0;
+            while ((pos = pending_data->find('\n')) != std::string::npos) {
+                std::string line = pending_data->substr(0, pos);
+                pending_data->erase(0, pos + 1);
+                lines++;
+                bytes += line.size();
+            }
+        }
+    };
+}
+
+Drain line_reader() {
+    auto events = std::make_shared<LineReader>();
+    return [events](int fd, size_t& lines, size_t& bytes) {
+        while (true) {
+            ssize_t num_read = events->fill(fd);
+            if (num_read <= 0) return num_read == -1 && errno == EAGAIN;
+
+            std::string_view line;
+            while (events->next_line(line)) {
+                lines++;
+                bytes += line.size();
+            }
+        }
+    };
+}
+
+int main(int argc, char* argv[]) {
+    size_t count = (argc > 1) ? strtoul(argv[1], nullptr, 10) : 2000000;
+    std::string data = make_events(count);
+
+    struct Variant {
+        const char* name;
+        std::function<Drain()> make;
+    } variants[] = {
+        {"legacy 1 KiB buffer", [] { return legacy_reader(1024); }},
+        {"legacy 4 KiB buffer", [] { return legacy_reader(4096); }},
+        {"LineReader", [] { return line_reader(); }},
+    };
+
+    printf("%zu events, %.1f MiB\n", count, data.size() / 1048576.0);
+    for (const Variant& variant : variants) {
+        size_t lines = 0;
+        double seconds = run(data, variant.make(), lines);
+        printf("%-22s %10.0f lines/s  (%zu lines, %.3f s)\n", variant.name, lines / seconds, lines, seconds);
+    }
+    return 0;
+}
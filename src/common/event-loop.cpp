@@ -0,0 +1,200 @@
+#include "event-loop.hpp"
+
+#include <cerrno>
+#include <chrono>
+#include <sys/epoll.h>
+#include <sys/signalfd.h>
+#include <sys/timerfd.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+
+namespace {
+
+itimerspec make_timer_spec(int delay_ms, bool repeat) {
+    itimerspec spec{};
+    spec.it_value.tv_sec = delay_ms / 1000;
+    spec.it_value.tv_nsec = (long)(delay_ms % 1000) * 1000000L;
+    if (repeat) spec.it_interval = spec.it_value;
+    return spec;
+}
+
+}
+
+EventLoop::EventLoop() {
+    epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    sigemptyset(&signal_mask);
+}
+
+EventLoop::~EventLoop() {
+    for (const auto& timer : timers) close(timer.first);
+    if (signal_fd != -1) close(signal_fd);
+    if (epoll_fd != -1) close(epoll_fd);
+}
+
+bool EventLoop::add_fd(int fd, uint32_t events, FdCallback callback) {
+    if (epoll_fd == -1 || fd < 0) return false;
+
+    epoll_event ev{};
+    ev.events = events;
+    ev.data.fd = fd;
+    if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &ev) == -1) return false;
+
+    callbacks[fd] = std::move(callback);
+    return true;
+}
+
+void EventLoop::remove_fd(int fd) {
+    if (callbacks.erase(fd) == 0) return;
+    epoll_ctl(epoll_fd, EPOLL_CTL_DEL, fd, nullptr);
+}
+
+int EventLoop::add_timer(int delay_ms, bool repeat, TimerCallback callback) {
+    int tfd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (tfd == -1) return -1;
+
+    bool added = add_fd(tfd, EPOLLIN, [this, tfd](uint32_t) {
+        uint64_t expirations;
+        if (read(tfd, &expirations, sizeof(expirations)) != sizeof(expirations)) return;
+        auto it = timers.find(tfd);
+        if (it != timers.end()) {
+            TimerCallback callback = it->second;
+            callback();
+        }
+    });
+    if (!added) {
+        close(tfd);
+        return -1;
+    }
+
+    timers[tfd] = std::move(callback);
+    set_timer(tfd, delay_ms, repeat);
+    return tfd;
+}
+
+void EventLoop::set_timer(int timer_id, int delay_ms, bool repeat) {
+    if (timers.count(timer_id) == 0) return;
+    itimerspec spec = make_timer_spec(delay_ms, repeat);
+    timerfd_settime(timer_id, 0, &spec, nullptr);
+}
+
+void EventLoop::remove_timer(int timer_id) {
+    if (timers.erase(timer_id) == 0) return;
+    remove_fd(timer_id);
+    close(timer_id);
+}
+
+bool EventLoop::watch_signal(int signo) {
+    if (sigismember(&signal_mask, signo) == 1) return signal_fd != -1;
+
+    sigaddset(&signal_mask, signo);
+    if (sigprocmask(SIG_BLOCK, &signal_mask, nullptr) == -1) return false;
+
+    // Passing the existing fd only updates its mask.
+    int fd = signalfd(signal_fd, &signal_mask, SFD_NONBLOCK | SFD_CLOEXEC);
+    if (fd == -1) return false;
+    if (signal_fd == -1) {
+        signal_fd = fd;
+        if (!add_fd(signal_fd, EPOLLIN, [this](uint32_t) { handle_signals(); })) return false;
+    }
+    return true;
+}
+
+bool EventLoop::add_signal(int signo, SignalCallback callback) {
+    if (!watch_signal(signo)) return false;
+    signal_callbacks[signo] = std::move(callback);
+    return true;
+}
+
+bool EventLoop::watch_child(pid_t pid, ChildCallback callback) {
+    if (pid <= 0 || !watch_signal(SIGCHLD)) return false;
+    children[pid] = std::move(callback);
+
+    // The child may have exited before SIGCHLD was blocked, in which case
+    // that signal is already gone; queue a fresh one so it is picked up.
+    siginfo_t info{};
+    if (waitid(P_PID, pid, &info, WEXITED | WNOHANG | WNOWAIT) == 0 && info.si_pid == pid) {
+        kill(getpid(), SIGCHLD);
+    }
+    return true;
+}
+
+void EventLoop::unblock_signals() const {
+    sigprocmask(SIG_UNBLOCK, &signal_mask, nullptr);
+}
+
+void EventLoop::handle_signals() {
+    signalfd_siginfo info;
+    bool child_exited = false;
+    while (read(signal_fd, &info, sizeof(info)) == sizeof(info)) {
+        int signo = static_cast<int>(info.ssi_signo);
+        if (signo == SIGCHLD) child_exited = true;
+
+        auto it = signal_callbacks.find(signo);
+        if (it != signal_callbacks.end()) {
+            SignalCallback callback = it->second;
+            callback();
+        }
+    }
+    // SIGCHLD coalesces, so every watched child is checked on each delivery.
+    if (child_exited) reap_children();
+}
+
+void EventLoop::reap_children() {
+    // Callbacks run after the scan, since they may watch a new child.
+    std::vector<std::pair<ChildCallback, int>> exited;
+    for (auto it = children.begin(); it != children.end();) {
+        int status = 0;
+        if (waitpid(it->first, &status, WNOHANG) == it->first) {
+            exited.emplace_back(std::move(it->second), status);
+            it = children.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    for (auto& child : exited) child.first(child.second);
+}
+
+bool EventLoop::wait_and_dispatch(int timeout_ms) {
+    epoll_event events[32];
+    int count = epoll_wait(epoll_fd, events, 32, timeout_ms);
+    if (count == -1) return errno == EINTR;
+
+    for (int i = 0; i < count && running; ++i) {
+        // A previous callback may have removed this source already.
+        auto it = callbacks.find(events[i].data.fd);
+        if (it == callbacks.end()) continue;
+        FdCallback callback = it->second;
+        callback(events[i].events);
+    }
+    return true;
+}
+
+void EventLoop::run() {
+    if (epoll_fd == -1 || stopped) return;
+
+    running = true;
+    while (running && !callbacks.empty()) {
+        if (!wait_and_dispatch(-1)) break;
+    }
+    running = false;
+}
+
+bool EventLoop::run_until(std::function<bool()> done, int timeout_ms) {
+    if (epoll_fd == -1 || stopped) return done();
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+    running = true;
+    while (running && !callbacks.empty() && !done()) {
+        int wait_ms = -1;
+        if (timeout_ms >= 0) {
+            auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now());
+            if (left.count() <= 0) break;
+            wait_ms = static_cast<int>(left.count());
+        }
+        if (!wait_and_dispatch(wait_ms)) break;
+    }
+    running = false;
+    return done();
+}
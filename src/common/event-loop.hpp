@@ -0,0 +1,72 @@
+#pragma once
+
+#include <csignal>
+#include <cstdint>
+#include <functional>
+#include <sys/types.h>
+#include <unordered_map>
+
+// Single-threaded epoll reactor. Callbacks run on the thread calling run();
+// nothing here polls or sleeps, so an idle daemon stays blocked in epoll_wait.
+class EventLoop {
+public:
+    using FdCallback = std::function<void(uint32_t events)>;
+    using TimerCallback = std::function<void()>;
+    using SignalCallback = std::function<void()>;
+    using ChildCallback = std::function<void(int status)>;
+
+    EventLoop();
+    ~EventLoop();
+    EventLoop(const EventLoop&) = delete;
+    EventLoop& operator=(const EventLoop&) = delete;
+
+    // Watches fd for the given EPOLL* events. The fd stays owned by the caller.
+    bool add_fd(int fd, uint32_t events, FdCallback callback);
+    void remove_fd(int fd);
+
+    // Creates a timerfd firing after delay_ms, and then every delay_ms if
+    // repeat is set. Returns a timer id (the timerfd) or -1.
+    int add_timer(int delay_ms, bool repeat, TimerCallback callback);
+    // Re-arms an existing timer; a delay of 0 disarms it.
+    void set_timer(int timer_id, int delay_ms, bool repeat);
+    void remove_timer(int timer_id);
+
+    // Blocks signo for the calling thread and delivers it through a signalfd.
+    // Register signals before starting any threads so they inherit the mask.
+    bool add_signal(int signo, SignalCallback callback);
+
+    // Calls callback with the wait status once child pid (which must be a
+    // child of this process) exits, then reaps it.
+    bool watch_child(pid_t pid, ChildCallback callback);
+
+    // Unblocks the signals taken over by add_signal(). Call this in a forked
+    // child before exec, since blocked signals survive exec.
+    void unblock_signals() const;
+
+    // Runs until stop() is called or no sources are left.
+    void run();
+    // Runs like run() but also returns once done() holds or timeout_ms has
+    // passed (-1 waits forever). done() is checked before waiting and after
+    // each batch of callbacks. Returns the final value of done().
+    bool run_until(std::function<bool()> done, int timeout_ms);
+    // Ends run() or run_until(); later calls to either return immediately.
+    void stop() { running = false; stopped = true; }
+    bool is_stopped() const { return stopped; }
+
+private:
+    int epoll_fd = -1;
+    bool running = false;
+    bool stopped = false;
+    std::unordered_map<int, FdCallback> callbacks;
+    std::unordered_map<int, TimerCallback> timers;
+
+    int signal_fd = -1;
+    sigset_t signal_mask;
+    std::unordered_map<int, SignalCallback> signal_callbacks;
+    std::unordered_map<pid_t, ChildCallback> children;
+
+    bool watch_signal(int signo);
+    void handle_signals();
+    void reap_children();
+    bool wait_and_dispatch(int timeout_ms);
+};
@@ -0,0 +1,26 @@
+#include "event-socket.hpp"
+
+#include <cerrno>
+#include <string_view>
+#include <sys/epoll.h>
+
+bool add_event_socket(EventLoop& loop, int fd, LineReader& reader, const EventDispatcher& dispatcher,
+                      std::function<void()> on_batch, std::function<void()> on_closed) {
+    return loop.add_fd(fd, EPOLLIN, [&loop, fd, &reader, &dispatcher, on_batch, on_closed](uint32_t) {
+        while (true) {
+            ssize_t num_read = reader.fill(fd);
+            if (num_read > 0) {
+                std::string_view line;
+                while (reader.next_line(line)) dispatcher.dispatch(line);
+                continue;
+            }
+            if (num_read == -1 && errno == EINTR) continue;
+            if (num_read == -1 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+
+            loop.remove_fd(fd);
+            if (on_closed) on_closed();
+            return;
+        }
+        if (on_batch) on_batch();
+    });
+}
@@ -0,0 +1,16 @@
+#pragma once
+
+#include <functional>
+
+#include "event-loop.hpp"
+#include "hyprland-events.hpp"
+#include "line-reader.hpp"
+
+// Feeds a non-blocking socket2 connection (connect_events(SOCK_NONBLOCK))
+// through reader into dispatcher. Each wakeup reads until the socket is
+// drained and then runs on_batch, so a daemon acts once per burst of events.
+// Once Hyprland closes the socket or a read fails, fd is removed from loop
+// and on_closed runs; the fd stays owned by the caller. reader and
+// dispatcher must outlive the registration.
+bool add_event_socket(EventLoop& loop, int fd, LineReader& reader, const EventDispatcher& dispatcher,
+                      std::function<void()> on_batch, std::function<void()> on_closed);
@@ -0,0 +1,46 @@
+#include "file-watch.hpp"
+
+#include <sys/epoll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#include <utility>
+
+FileWatch::FileWatch(EventLoop& loop) : loop(loop) {}
+
+FileWatch::~FileWatch() {
+    if (inotify_fd == -1) return;
+    loop.remove_fd(inotify_fd);
+    close(inotify_fd);
+}
+
+bool FileWatch::watch(const std::string& path, ChangeCallback callback) {
+    size_t slash = path.find_last_of('/');
+    if (inotify_fd != -1 || slash == std::string::npos) return false;
+
+    inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotify_fd == -1) return false;
+    if (inotify_add_watch(inotify_fd, path.substr(0, slash).c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_DELETE) == -1 ||
+        !loop.add_fd(inotify_fd, EPOLLIN, [this](uint32_t) { handle_events(); })) {
+        close(inotify_fd);
+        inotify_fd = -1;
+        return false;
+    }
+
+    file_name = path.substr(slash + 1);
+    on_change = std::move(callback);
+    return true;
+}
+
+void FileWatch::handle_events() {
+    alignas(inotify_event) char events[4096];
+    bool changed = false;
+    ssize_t len;
+    while ((len = read(inotify_fd, events, sizeof(events))) > 0) {
+        for (char* ptr = events; ptr < events + len; ) {
+            const inotify_event* ev = (const inotify_event*)ptr;
+            if (ev->len > 0 && file_name == ev->name) changed = true;
+            ptr += sizeof(inotify_event) + ev->len;
+        }
+    }
+    if (changed && on_change) on_change();
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <functional>
+#include <string>
+
+#include "event-loop.hpp"
+
+// Reports changes to one file, such as a config, through the event loop. The
+// directory is watched rather than the file, because editors and skin scripts
+// replace the file instead of writing it in place.
+class FileWatch {
+public:
+    using ChangeCallback = std::function<void()>;
+
+    explicit FileWatch(EventLoop& loop);
+    ~FileWatch();
+    FileWatch(const FileWatch&) = delete;
+    FileWatch& operator=(const FileWatch&) = delete;
+
+    // Calls on_change once per batch of events in which path was written,
+    // moved into place or deleted. Returns false if the watch could not be
+    // set up.
+    bool watch(const std::string& path, ChangeCallback on_change);
+
+private:
+    EventLoop& loop;
+    int inotify_fd = -1;
+    std::string file_name;
+    ChangeCallback on_change;
+
+    void handle_events();
+};
@@ -0,0 +1,331 @@
+#pragma once
+
+#include <array>
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string_view>
+
+// Hyprland socket2 events. Names are classified through an open-addressed
+// hash table built at compile time, so classifying a line costs one hash and
+// one comparison no matter how many events a daemon handles.
+enum class HyprEvent : uint8_t {
+    Unknown,
+    Workspace, WorkspaceV2, FocusedMon, FocusedMonV2,
+    ActiveWindow, ActiveWindowV2, Fullscreen,
+    MonitorAdded, MonitorAddedV2, MonitorRemoved, MonitorRemovedV2,
+    CreateWorkspace, CreateWorkspaceV2, DestroyWorkspace, DestroyWorkspaceV2,
+    MoveWorkspace, MoveWorkspaceV2, RenameWorkspace,
+    ActiveSpecial, ActiveSpecialV2, ActiveLayout,
+    OpenWindow, CloseWindow, MoveWindow, MoveWindowV2,
+    WindowTitle, WindowTitleV2, OpenLayer, CloseLayer,
+    Submap, ChangeFloatingMode, Urgent, Screencast,
+    ToggleGroup, MoveIntoGroup, MoveOutOfGroup, IgnoreGroupLock, LockGroups,
+    ConfigReloaded, Pin, Minimized, Bell,
+    Count
+};
+
+namespace hyprland_events_detail {
+
+struct NamedEvent {
+    std::string_view name;
+    HyprEvent event;
+};
+
+inline constexpr NamedEvent EVENT_NAMES[] = {
+    {"workspace", HyprEvent::Workspace}, {"workspacev2", HyprEvent::WorkspaceV2},
+    {"focusedmon", HyprEvent::FocusedMon}, {"focusedmonv2", HyprEvent::FocusedMonV2},
+    {"activewindow", HyprEvent::ActiveWindow}, {"activewindowv2", HyprEvent::ActiveWindowV2},
+    {"fullscreen", HyprEvent::Fullscreen},
+    {"monitoradded", HyprEvent::MonitorAdded}, {"monitoraddedv2", HyprEvent::MonitorAddedV2},
+    {"monitorremoved", HyprEvent::MonitorRemoved}, {"monitorremovedv2", HyprEvent::MonitorRemovedV2},
+    {"createworkspace", HyprEvent::CreateWorkspace}, {"createworkspacev2", HyprEvent::CreateWorkspaceV2},
+    {"destroyworkspace", HyprEvent::DestroyWorkspace}, {"destroyworkspacev2", HyprEvent::DestroyWorkspaceV2},
+    {"moveworkspace", HyprEvent::MoveWorkspace}, {"moveworkspacev2", HyprEvent::MoveWorkspaceV2},
+    {"renameworkspace", HyprEvent::RenameWorkspace},
+    {"activespecial", HyprEvent::ActiveSpecial}, {"activespecialv2", HyprEvent::ActiveSpecialV2},
+    {"activelayout", HyprEvent::ActiveLayout},
+    {"openwindow", HyprEvent::OpenWindow}, {"closewindow", HyprEvent::CloseWindow},
+    {"movewindow", HyprEvent::MoveWindow}, {"movewindowv2", HyprEvent::MoveWindowV2},
+    {"windowtitle", HyprEvent::WindowTitle}, {"windowtitlev2", HyprEvent::WindowTitleV2},
+    {"openlayer", HyprEvent::OpenLayer}, {"closelayer", HyprEvent::CloseLayer},
+    {"submap", HyprEvent::Submap}, {"changefloatingmode", HyprEvent::ChangeFloatingMode},
+    {"urgent", HyprEvent::Urgent}, {"screencast", HyprEvent::Screencast},
+    {"togglegroup", HyprEvent::ToggleGroup}, {"moveintogroup", HyprEvent::MoveIntoGroup},
+    {"moveoutofgroup", HyprEvent::MoveOutOfGroup}, {"ignoregrouplock", HyprEvent::IgnoreGroupLock},
+    {"lockgroups", HyprEvent::LockGroups}, {"configreloaded", HyprEvent::ConfigReloaded},
+    {"pin", HyprEvent::Pin}, {"minimized", HyprEvent::Minimized}, {"bell", HyprEvent::Bell},
+};
+
+inline constexpr size_t EVENT_COUNT = sizeof(EVENT_NAMES) / sizeof(EVENT_NAMES[0]);
+inline constexpr size_t TABLE_SIZE = 128;
+static_assert(EVENT_COUNT < TABLE_SIZE / 2, "event table too full");
+
+constexpr uint32_t hash_name(std::string_view name) {
+    uint32_t hash = 2166136261u;
+    for (char c : name) {
+        hash ^= static_cast<uint8_t>(c);
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+// Slots hold an index into EVENT_NAMES plus one; zero marks an empty slot.
+constexpr std::array<uint8_t, TABLE_SIZE> build_table() {
+    std::array<uint8_t, TABLE_SIZE> table{};
+    for (size_t i = 0; i < EVENT_COUNT; ++i) {
+        size_t slot = hash_name(EVENT_NAMES[i].name) & (TABLE_SIZE - 1);
+        while (table[slot] != 0) slot = (slot + 1) & (TABLE_SIZE - 1);
+        table[slot] = static_cast<uint8_t>(i + 1);
+    }
+    return table;
+}
+
+inline constexpr std::array<uint8_t, TABLE_SIZE> EVENT_TABLE = build_table();
+
+}
+
+constexpr HyprEvent classify_event(std::string_view name) {
+    using namespace hyprland_events_detail;
+    size_t slot = hash_name(name) & (TABLE_SIZE - 1);
+    while (EVENT_TABLE[slot] != 0) {
+        const NamedEvent& entry = EVENT_NAMES[EVENT_TABLE[slot] - 1];
+        if (entry.name == name) return entry.event;
+        slot = (slot + 1) & (TABLE_SIZE - 1);
+    }
+    return HyprEvent::Unknown;
+}
+
+static_assert(classify_event("workspacev2") == HyprEvent::WorkspaceV2, "event table lookup");
+static_assert(classify_event("workspace") == HyprEvent::Workspace, "event table lookup");
+static_assert(classify_event("createworkspace") == HyprEvent::CreateWorkspace, "event table lookup");
+static_assert(classify_event("workspacev3") == HyprEvent::Unknown, "event table lookup");
+
+// Splits "name>>payload". Returns false for lines without the separator.
+constexpr bool split_event_line(std::string_view line, HyprEvent& event, std::string_view& payload) {
+    size_t sep = line.find(">>");
+    if (sep == std::string_view::npos) return false;
+    event = classify_event(line.substr(0, sep));
+    payload = line.substr(sep + 2);
+    return true;
+}
+
+// Takes the next comma-separated field off the front of rest. The last field
+// of an event (titles, mostly) is taken whole, commas included.
+constexpr std::string_view next_field(std::string_view& rest, bool last = false) {
+    size_t comma = last ? std::string_view::npos : rest.find(',');
+    std::string_view field = rest.substr(0, comma);
+    rest = (comma == std::string_view::npos) ? std::string_view() : rest.substr(comma + 1);
+    return field;
+}
+
+// Window addresses arrive as "0x55d1..." in JSON replies and "55d1..." in
+// socket2 events; both decode to the same key.
+inline uint64_t parse_address(std::string_view text) {
+    if (text.rfind("0x", 0) == 0) text.remove_prefix(2);
+    uint64_t value = 0;
+    std::from_chars(text.data(), text.data() + text.size(), value, 16);
+    return value;
+}
+
+inline int parse_int(std::string_view text) {
+    int value = 0;
+    std::from_chars(text.data(), text.data() + text.size(), value);
+    return value;
+}
+
+// Typed payloads. Every view points into the event line and is only valid
+// while the handler runs.
+struct OpenWindowEvent {
+    static constexpr HyprEvent id = HyprEvent::OpenWindow;
+    std::string_view address, workspace, window_class, title;
+
+    static bool parse(std::string_view payload, OpenWindowEvent& out) {
+        out.address = next_field(payload);
+        out.workspace = next_field(payload);
+        out.window_class = next_field(payload);
+        out.title = next_field(payload, true);
+        return !out.address.empty();
+    }
+};
+
+struct CloseWindowEvent {
+    static constexpr HyprEvent id = HyprEvent::CloseWindow;
+    std::string_view address;
+
+    static bool parse(std::string_view payload, CloseWindowEvent& out) {
+        out.address = payload;
+        return !out.address.empty();
+    }
+};
+
+struct MoveWindowV2Event {
+    static constexpr HyprEvent id = HyprEvent::MoveWindowV2;
+    std::string_view address;
+    int workspace_id;
+    std::string_view workspace;
+
+    static bool parse(std::string_view payload, MoveWindowV2Event& out) {
+        out.address = next_field(payload);
+        std::string_view id_field = next_field(payload);
+        out.workspace_id = parse_int(id_field);
+        out.workspace = next_field(payload, true);
+        return !out.address.empty() && !id_field.empty();
+    }
+};
+
+struct WindowTitleV2Event {
+    static constexpr HyprEvent id = HyprEvent::WindowTitleV2;
+    std::string_view address, title;
+
+    static bool parse(std::string_view payload, WindowTitleV2Event& out) {
+        out.address = next_field(payload);
+        out.title = next_field(payload, true);
+        return !out.address.empty();
+    }
+};
+
+struct ActiveWindowV2Event {
+    static constexpr HyprEvent id = HyprEvent::ActiveWindowV2;
+    std::string_view address;
+
+    static bool parse(std::string_view payload, ActiveWindowV2Event& out) {
+        out.address = payload;
+        return true;
+    }
+};
+
+struct FullscreenEvent {
+    static constexpr HyprEvent id = HyprEvent::Fullscreen;
+    bool enabled;
+
+    static bool parse(std::string_view payload, FullscreenEvent& out) {
+        out.enabled = payload == "1";
+        return true;
+    }
+};
+
+struct WorkspaceV2Event {
+    static constexpr HyprEvent id = HyprEvent::WorkspaceV2;
+    int workspace_id;
+    std::string_view workspace;
+
+    static bool parse(std::string_view payload, WorkspaceV2Event& out) {
+        std::string_view id_field = next_field(payload);
+        out.workspace_id = parse_int(id_field);
+        out.workspace = next_field(payload, true);
+        return !id_field.empty();
+    }
+};
+
+// createworkspacev2, destroyworkspacev2 and renameworkspace all carry "id,name".
+template <HyprEvent Id>
+struct WorkspaceIdNameEvent {
+    static constexpr HyprEvent id = Id;
+    int workspace_id;
+    std::string_view workspace;
+
+    static bool parse(std::string_view payload, WorkspaceIdNameEvent& out) {
+        std::string_view id_field = next_field(payload);
+        out.workspace_id = parse_int(id_field);
+        out.workspace = next_field(payload, true);
+        return !id_field.empty();
+    }
+};
+
+using CreateWorkspaceV2Event = WorkspaceIdNameEvent<HyprEvent::CreateWorkspaceV2>;
+using DestroyWorkspaceV2Event = WorkspaceIdNameEvent<HyprEvent::DestroyWorkspaceV2>;
+using RenameWorkspaceEvent = WorkspaceIdNameEvent<HyprEvent::RenameWorkspace>;
+
+struct FocusedMonV2Event {
+    static constexpr HyprEvent id = HyprEvent::FocusedMonV2;
+    std::string_view monitor;
+    int workspace_id;
+
+    static bool parse(std::string_view payload, FocusedMonV2Event& out) {
+        out.monitor = next_field(payload);
+        std::string_view id_field = next_field(payload);
+        out.workspace_id = parse_int(id_field);
+        return !id_field.empty();
+    }
+};
+
+struct ActiveSpecialV2Event {
+    static constexpr HyprEvent id = HyprEvent::ActiveSpecialV2;
+    int workspace_id;
+    std::string_view workspace, monitor;
+
+    static bool parse(std::string_view payload, ActiveSpecialV2Event& out) {
+        out.workspace_id = parse_int(next_field(payload));
+        out.workspace = next_field(payload);
+        out.monitor = next_field(payload, true);
+        return !out.monitor.empty();
+    }
+};
+
+struct MonitorRemovedEvent {
+    static constexpr HyprEvent id = HyprEvent::MonitorRemoved;
+    std::string_view monitor;
+
+    static bool parse(std::string_view payload, MonitorRemovedEvent& out) {
+        out.monitor = payload;
+        return !out.monitor.empty();
+    }
+};
+
+struct OpenLayerEvent {
+    static constexpr HyprEvent id = HyprEvent::OpenLayer;
+    std::string_view layer;
+
+    static bool parse(std::string_view payload, OpenLayerEvent& out) {
+        out.layer = payload;
+        return !out.layer.empty();
+    }
+};
+
+struct CloseLayerEvent {
+    static constexpr HyprEvent id = HyprEvent::CloseLayer;
+    std::string_view layer;
+
+    static bool parse(std::string_view payload, CloseLayerEvent& out) {
+        out.layer = payload;
+        return !out.layer.empty();
+    }
+};
+
+// Routes socket2 lines to handlers indexed by event id. Lines for events
+// without a handler are dropped after classification.
+class EventDispatcher {
+public:
+    using Handler = std::function<void(std::string_view payload)>;
+
+    void on(HyprEvent event, Handler handler) {
+        handlers[static_cast<size_t>(event)] = std::move(handler);
+    }
+
+    // Registers a handler taking one of the typed payloads above; payloads
+    // that fail to parse are skipped.
+    template <typename Event, typename Callback>
+    void on(Callback callback) {
+        on(Event::id, [callback](std::string_view payload) {
+            Event event;
+            if (Event::parse(payload, event)) callback(event);
+        });
+    }
+
+    // Returns true if the line had a handler.
+    bool dispatch(std::string_view line) const {
+        HyprEvent event;
+        std::string_view payload;
+        if (!split_event_line(line, event, payload)) return false;
+
+        const Handler& handler = handlers[static_cast<size_t>(event)];
+        if (!handler) return false;
+        handler(payload);
+        return true;
+    }
+
+private:
+    std::array<Handler, static_cast<size_t>(HyprEvent::Count)> handlers;
+};
@@ -0,0 +1,292 @@
+#include "hyprland-ipc.hpp"
+#include "hyprland-events.hpp"
+#include "json-reader.hpp"
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace {
+
+bool fill_address(sockaddr_un& addr, const std::string& path) {
+    if (path.size() >= sizeof(addr.sun_path)) return false;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    memcpy(addr.sun_path, path.c_str(), path.size());
+    return true;
+}
+
+int connect_unix(const sockaddr_un& addr, int extra_flags) {
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC | extra_flags, 0);
+    if (fd == -1) return -1;
+    if (connect(fd, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) == -1 && errno != EINPROGRESS) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+bool write_all(int fd, std::string_view data) {
+    while (!data.empty()) {
+        ssize_t written = write(fd, data.data(), data.size());
+        if (written == -1) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        data.remove_prefix(written);
+    }
+    return true;
+}
+
+// Hyprland joins the replies of a batch with "\n\n\n". JSON and one-word
+// replies never contain that, so splitting on it is unambiguous for them.
+const std::string_view BATCH_SEPARATOR = "\n\n\n";
+
+std::vector<std::string> split_batch_reply(std::string_view reply, size_t count) {
+    std::vector<std::string> parts;
+    parts.reserve(count);
+    while (parts.size() + 1 < count) {
+        size_t sep = reply.find(BATCH_SEPARATOR);
+        if (sep == std::string_view::npos) return {};
+        parts.emplace_back(reply.substr(0, sep));
+        reply.remove_prefix(sep + BATCH_SEPARATOR.size());
+    }
+    if (reply.size() >= BATCH_SEPARATOR.size() && reply.substr(reply.size() - BATCH_SEPARATOR.size()) == BATCH_SEPARATOR) {
+        reply.remove_suffix(BATCH_SEPARATOR.size());
+    }
+    parts.emplace_back(reply);
+    return parts;
+}
+
+void read_workspace_ref(JsonReader& reader, int& id, std::string* name) {
+    if (!reader.enter_object()) return;
+    std::string_view key, raw;
+    while (reader.next_member(key)) {
+        if (key == "id") reader.read_int(id);
+        else if (name && key == "name" && reader.read_string(raw)) *name = JsonReader::unescape(raw);
+        else reader.skip();
+    }
+}
+
+void parse_monitors(std::string_view reply, std::vector<HyprlandSnapshot::Monitor>& out) {
+    JsonReader reader(reply);
+    if (!reader.enter_array()) return;
+    while (reader.next_element()) {
+        if (!reader.enter_object()) continue;
+        HyprlandSnapshot::Monitor monitor;
+        std::string_view key, raw;
+        while (reader.next_member(key)) {
+            if (key == "name" && reader.read_string(raw)) monitor.name = JsonReader::unescape(raw);
+            else if (key == "x") reader.read_int(monitor.x);
+            else if (key == "y") reader.read_int(monitor.y);
+            else if (key == "width") reader.read_int(monitor.width);
+            else if (key == "height") reader.read_int(monitor.height);
+            else if (key == "scale") reader.read_double(monitor.scale);
+            else if (key == "transform") reader.read_int(monitor.transform);
+            else if (key == "reserved") {
+                if (!reader.enter_array()) continue;
+                for (size_t i = 0; reader.next_element(); ++i) {
+                    if (i < monitor.reserved.size()) reader.read_int(monitor.reserved[i]);
+                    else reader.skip();
+                }
+            }
+            else if (key == "activeWorkspace") read_workspace_ref(reader, monitor.active_workspace, &monitor.active_workspace_name);
+            else if (key == "specialWorkspace") read_workspace_ref(reader, monitor.special_workspace, nullptr);
+            else if (key == "focused") reader.read_bool(monitor.focused);
+            else reader.skip();
+        }
+        // Special workspaces have negative ids; 0 means none is open.
+        if (monitor.special_workspace > 0) monitor.special_workspace = 0;
+        if (!monitor.name.empty()) out.push_back(std::move(monitor));
+    }
+}
+
+void parse_workspaces(std::string_view reply, std::vector<HyprlandSnapshot::Workspace>& out) {
+    JsonReader reader(reply);
+    if (!reader.enter_array()) return;
+    while (reader.next_element()) {
+        if (!reader.enter_object()) continue;
+        HyprlandSnapshot::Workspace workspace;
+        std::string_view key, raw;
+        while (reader.next_member(key)) {
+            if (key == "id") reader.read_int(workspace.id);
+            else if (key == "name" && reader.read_string(raw)) workspace.name = JsonReader::unescape(raw);
+            else if (key == "monitor" && reader.read_string(raw)) workspace.monitor = JsonReader::unescape(raw);
+            else if (key == "windows") reader.read_int(workspace.windows);
+            else reader.skip();
+        }
+        if (workspace.id != -999) out.push_back(std::move(workspace));
+    }
+}
+
+void parse_clients(std::string_view reply, std::vector<HyprlandSnapshot::Client>& out) {
+    JsonReader reader(reply);
+    if (!reader.enter_array()) return;
+    while (reader.next_element()) {
+        if (!reader.enter_object()) continue;
+        HyprlandSnapshot::Client client;
+        std::string_view key, raw;
+        while (reader.next_member(key)) {
+            if (key == "address" && reader.read_string(raw)) client.address = parse_address(raw);
+            else if (key == "pid") reader.read_int(client.pid);
+            else if (key == "workspace") read_workspace_ref(reader, client.workspace, &client.workspace_name);
+            else if (key == "class" && reader.read_string(raw)) client.window_class = JsonReader::unescape(raw);
+            else if (key == "title" && reader.read_string(raw)) client.title = JsonReader::unescape(raw);
+            else reader.skip();
+        }
+        if (client.address != 0) out.push_back(std::move(client));
+    }
+}
+
+// j/layers maps each monitor to {"levels": {"0": [{"namespace": ...}, ...], ...}}.
+void parse_layers(std::string_view reply, std::vector<HyprlandSnapshot::Layer>& out) {
+    JsonReader reader(reply);
+    if (!reader.enter_object()) return;
+    std::string_view monitor, key, level, raw;
+    while (reader.next_member(monitor)) {
+        if (!reader.enter_object()) continue;
+        while (reader.next_member(key)) {
+            if (key != "levels") {
+                reader.skip();
+                continue;
+            }
+            if (!reader.enter_object()) continue;
+            while (reader.next_member(level)) {
+                if (!reader.enter_array()) continue;
+                while (reader.next_element()) {
+                    if (!reader.enter_object()) continue;
+                    HyprlandSnapshot::Layer layer;
+                    layer.monitor = std::string(monitor);
+                    while (reader.next_member(key)) {
+                        if (key == "namespace" && reader.read_string(raw)) layer.name_space = JsonReader::unescape(raw);
+                        else reader.skip();
+                    }
+                    if (!layer.name_space.empty()) out.push_back(std::move(layer));
+                }
+            }
+        }
+    }
+}
+
+}
+
+HyprlandIPC::HyprlandIPC() {
+    const char* runtime_dir = getenv("XDG_RUNTIME_DIR");
+    const char* signature = getenv("HYPRLAND_INSTANCE_SIGNATURE");
+    if (!runtime_dir || !signature) return;
+
+    std::string base = std::string(runtime_dir) + "/hypr/" + std::string(signature);
+    is_available = fill_address(request_addr, base + "/.socket.sock") &&
+                   fill_address(event_addr, base + "/.socket2.sock");
+}
+
+std::string HyprlandIPC::request(std::string_view command) {
+    if (!is_available) return "";
+
+    // Hyprland answers one command per connection and closes it afterwards,
+    // so only the resolved address and the read buffer are kept around.
+    int fd = connect_unix(request_addr, 0);
+    if (fd == -1) return "";
+
+    if (!write_all(fd, command)) {
+        close(fd);
+        return "";
+    }
+
+    std::string response;
+    while (true) {
+        ssize_t bytes_read = read(fd, read_buffer.data(), read_buffer.size());
+        if (bytes_read > 0) {
+            response.append(read_buffer.data(), bytes_read);
+        } else if (bytes_read == -1 && errno == EINTR) {
+            continue;
+        } else {
+            break;
+        }
+    }
+    close(fd);
+
+    return response;
+}
+
+std::string HyprlandIPC::query_json(std::string_view what) {
+    std::string command = "j/";
+    command.append(what);
+    return request(command);
+}
+
+bool HyprlandIPC::dispatch(std::string_view args) {
+    std::string command = "dispatch ";
+    command.append(args);
+    return request(command) == "ok";
+}
+
+std::vector<std::string> HyprlandIPC::request_batch(const std::vector<std::string>& commands) {
+    if (commands.empty()) return {};
+
+    // Hyprland splits a batch on ';'.
+    std::string command = "[[BATCH]]";
+    for (size_t i = 0; i < commands.size(); ++i) {
+        if (i > 0) command += ';';
+        command += commands[i];
+    }
+    std::string reply = request(command);
+    if (reply.empty()) return {};
+    return split_batch_reply(reply, commands.size());
+}
+
+bool HyprlandIPC::dispatch_batch(const std::vector<std::string>& args) {
+    if (args.empty()) return true;
+
+    std::vector<std::string> commands;
+    commands.reserve(args.size());
+    for (const std::string& arg : args) commands.push_back("dispatch " + arg);
+
+    std::vector<std::string> replies = request_batch(commands);
+    if (replies.size() != args.size()) return false;
+    for (const std::string& reply : replies) {
+        if (reply != "ok") return false;
+    }
+    return true;
+}
+
+bool HyprlandIPC::snapshot(HyprlandSnapshot& out) {
+    std::vector<std::string> replies = request_batch({"j/monitors", "j/workspaces", "j/clients"});
+    // A batch reply that does not split cleanly is asked for again one
+    // request at a time; the parts are then no longer one moment, but close.
+    if (replies.size() != 3) {
+        replies = {query_json("monitors"), query_json("workspaces"), query_json("clients")};
+    }
+    if (replies[0].empty() || replies[0].front() != '[') return false;
+
+    out = HyprlandSnapshot();
+    parse_monitors(replies[0], out.monitors);
+    parse_workspaces(replies[1], out.workspaces);
+    parse_clients(replies[2], out.clients);
+    return true;
+}
+
+bool HyprlandIPC::monitors(std::vector<HyprlandSnapshot::Monitor>& out) {
+    std::string reply = query_json("monitors");
+    if (reply.empty() || reply.front() != '[') return false;
+
+    out.clear();
+    parse_monitors(reply, out);
+    return true;
+}
+
+bool HyprlandIPC::layers(std::vector<HyprlandSnapshot::Layer>& out) {
+    std::string reply = query_json("layers");
+    if (reply.empty() || reply.front() != '{') return false;
+
+    out.clear();
+    parse_layers(reply, out);
+    return true;
+}
+
+int HyprlandIPC::connect_events(int extra_flags) const {
+    if (!is_available) return -1;
+    return connect_unix(event_addr, extra_flags);
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <sys/un.h>
+
+// Compositor state read in one [[BATCH]] request, so every part describes
+// the same moment. Workspace ids are -999 where a reply had none.
+struct HyprlandSnapshot {
+    struct Monitor {
+        std::string name;
+        // width and height are the mode in physical pixels; x and y are
+        // logical. Odd transforms rotate by 90 degrees.
+        int x = 0, y = 0, width = 0, height = 0;
+        double scale = 1.0;
+        int transform = 0;
+        // Area taken by exclusive zones along each edge: left, top, right, bottom.
+        std::array<int, 4> reserved{};
+        int active_workspace = -999;
+        std::string active_workspace_name;
+        int special_workspace = 0;
+        bool focused = false;
+    };
+    struct Workspace {
+        int id = -999;
+        std::string name;
+        std::string monitor;
+        int windows = 0;
+    };
+    struct Client {
+        uint64_t address = 0;
+        int pid = -1;
+        int workspace = -999;
+        std::string workspace_name;
+        std::string window_class;
+        std::string title;
+    };
+    struct Layer {
+        std::string monitor;
+        std::string name_space;
+    };
+
+    std::vector<Monitor> monitors;
+    std::vector<Workspace> workspaces;
+    std::vector<Client> clients;
+};
+
+// Native client for Hyprland's request socket (.socket.sock) and event socket
+// (.socket2.sock). Socket paths are resolved once; every request is a plain
+// connect/write/read on a Unix socket instead of a fork/exec of hyprctl.
+class HyprlandIPC {
+public:
+    HyprlandIPC();
+
+    bool available() const { return is_available; }
+
+    // Sends a raw command (e.g. "j/clients", "cursorpos", "dispatch ...") and
+    // returns the full reply, or an empty string on failure.
+    std::string request(std::string_view command);
+
+    // Shorthand for request("j/" + what).
+    std::string query_json(std::string_view what);
+
+    // Sends "dispatch <args>" and returns true if Hyprland answered "ok".
+    bool dispatch(std::string_view args);
+
+    // Sends every "dispatch <args>" in a single [[BATCH]] request and returns
+    // true if Hyprland answered "ok" to all of them.
+    bool dispatch_batch(const std::vector<std::string>& args);
+
+    // Sends all commands as one [[BATCH]] request and returns their replies
+    // in order, or an empty vector if the request failed.
+    std::vector<std::string> request_batch(const std::vector<std::string>& commands);
+
+    // Reads monitors, workspaces and clients in one round-trip, or in three
+    // if the batch reply cannot be split.
+    bool snapshot(HyprlandSnapshot& out);
+    // Reads only the monitors (j/monitors).
+    bool monitors(std::vector<HyprlandSnapshot::Monitor>& out);
+    // Reads only the mapped layer surfaces (j/layers).
+    bool layers(std::vector<HyprlandSnapshot::Layer>& out);
+
+    // Opens a connection to .socket2.sock. Returns the fd or -1.
+    int connect_events(int extra_flags = 0) const;
+
+private:
+    bool is_available = false;
+    sockaddr_un request_addr{};
+    sockaddr_un event_addr{};
+    std::array<char, 65536> read_buffer;
+};
@@ -0,0 +1,258 @@
+#include "json-reader.hpp"
+
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+
+namespace {
+
+bool is_space(char c) {
+    return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+}
+
+bool is_number_char(char c) {
+    return (c >= '0' && c <= '9') || c == '-' || c == '+' || c == '.' || c == 'e' || c == 'E';
+}
+
+void append_utf8(std::string& out, uint32_t code) {
+    if (code < 0x80) {
+        out += static_cast<char>(code);
+    } else if (code < 0x800) {
+        out += static_cast<char>(0xC0 | (code >> 6));
+        out += static_cast<char>(0x80 | (code & 0x3F));
+    } else if (code < 0x10000) {
+        out += static_cast<char>(0xE0 | (code >> 12));
+        out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (code & 0x3F));
+    } else {
+        out += static_cast<char>(0xF0 | (code >> 18));
+        out += static_cast<char>(0x80 | ((code >> 12) & 0x3F));
+        out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (code & 0x3F));
+    }
+}
+
+uint32_t parse_hex4(std::string_view raw, size_t at) {
+    uint32_t value = 0;
+    if (at + 4 > raw.size()) return 0xFFFD;
+    auto result = std::from_chars(raw.data() + at, raw.data() + at + 4, value, 16);
+    return (result.ptr == raw.data() + at + 4) ? value : 0xFFFD;
+}
+
+}
+
+// Returns the next significant character without consuming it, or '\0' at
+// the end of the text.
+char JsonReader::peek() {
+    while (pos < text.size() && is_space(text[pos])) pos++;
+    return pos < text.size() ? text[pos] : '\0';
+}
+
+bool JsonReader::fail() {
+    error = true;
+    pos = text.size();
+    return false;
+}
+
+// Expects the cursor on an opening quote and leaves it past the closing one.
+bool JsonReader::skip_string() {
+    pos++;
+    while (pos < text.size()) {
+        const void* found = memchr(text.data() + pos, '"', text.size() - pos);
+        if (!found) break;
+        size_t quote = static_cast<const char*>(found) - text.data();
+
+        // The quote is escaped if an odd number of backslashes precede it.
+        size_t backslashes = 0;
+        while (quote - backslashes > pos && text[quote - backslashes - 1] == '\\') backslashes++;
+        pos = quote + 1;
+        if (backslashes % 2 == 0) return true;
+    }
+    return fail();
+}
+
+bool JsonReader::enter_object() {
+    if (peek() != '{') {
+        skip();
+        return false;
+    }
+    pos++;
+    return true;
+}
+
+bool JsonReader::next_member(std::string_view& key) {
+    char c = peek();
+    if (c == ',') {
+        pos++;
+        c = peek();
+    }
+    if (c == '}') {
+        pos++;
+        return false;
+    }
+    if (c != '"') return fail();
+
+    size_t start = pos + 1;
+    if (!skip_string()) return false;
+    key = text.substr(start, pos - 1 - start);
+
+    if (peek() != ':') return fail();
+    pos++;
+    return true;
+}
+
+bool JsonReader::enter_array() {
+    if (peek() != '[') {
+        skip();
+        return false;
+    }
+    pos++;
+    return true;
+}
+
+bool JsonReader::next_element() {
+    char c = peek();
+    if (c == ',') {
+        pos++;
+        c = peek();
+    }
+    if (c == ']') {
+        pos++;
+        return false;
+    }
+    return c != '\0' || fail();
+}
+
+bool JsonReader::read_int(int& out) {
+    char c = peek();
+    if (c != '-' && (c < '0' || c > '9')) {
+        skip();
+        return false;
+    }
+    auto result = std::from_chars(text.data() + pos, text.data() + text.size(), out);
+    // Fractions and exponents are dropped; the reply keeps parsing.
+    pos = result.ptr - text.data();
+    while (pos < text.size() && is_number_char(text[pos])) pos++;
+    return result.ec == std::errc();
+}
+
+bool JsonReader::read_double(double& out) {
+    char c = peek();
+    if (c != '-' && (c < '0' || c > '9')) {
+        skip();
+        return false;
+    }
+    auto result = std::from_chars(text.data() + pos, text.data() + text.size(), out);
+    pos = result.ptr - text.data();
+    while (pos < text.size() && is_number_char(text[pos])) pos++;
+    return result.ec == std::errc();
+}
+
+bool JsonReader::read_bool(bool& out) {
+    char c = peek();
+    if (text.compare(pos, 4, "true") == 0) {
+        out = true;
+        pos += 4;
+        return true;
+    }
+    if (text.compare(pos, 5, "false") == 0) {
+        out = false;
+        pos += 5;
+        return true;
+    }
+    if (c != '\0') skip();
+    return false;
+}
+
+bool JsonReader::read_string(std::string_view& raw) {
+    if (peek() != '"') {
+        skip();
+        return false;
+    }
+    size_t start = pos + 1;
+    if (!skip_string()) return false;
+    raw = text.substr(start, pos - 1 - start);
+    return true;
+}
+
+bool JsonReader::read_member_int(std::string_view key, int& out) {
+    if (!enter_object()) return false;
+    bool found = false;
+    std::string_view member;
+    while (next_member(member)) {
+        if (!found && member == key) found = read_int(out);
+        else skip();
+    }
+    return found;
+}
+
+bool JsonReader::skip() {
+    char c = peek();
+    if (c == '"') return skip_string();
+    if (c != '{' && c != '[') {
+        // Numbers, true, false and null run up to the next delimiter.
+        size_t start = pos;
+        while (pos < text.size() && !is_space(text[pos]) && text[pos] != ',' && text[pos] != '}' && text[pos] != ']') pos++;
+        return pos > start || fail();
+    }
+
+    // Brackets inside strings are stepped over with the strings.
+    int depth = 0;
+    while (pos < text.size()) {
+        c = text[pos];
+        if (c == '"') {
+            if (!skip_string()) return false;
+            continue;
+        }
+        pos++;
+        if (c == '{' || c == '[') depth++;
+        else if ((c == '}' || c == ']') && --depth == 0) return true;
+    }
+    return fail();
+}
+
+int JsonReader::count_elements() {
+    if (!enter_array()) return -1;
+    int count = 0;
+    while (next_element()) {
+        if (!skip()) return -1;
+        count++;
+    }
+    return error ? -1 : count;
+}
+
+std::string JsonReader::unescape(std::string_view raw) {
+    std::string out;
+    out.reserve(raw.size());
+    for (size_t i = 0; i < raw.size(); ++i) {
+        char c = raw[i];
+        if (c != '\\' || i + 1 == raw.size()) {
+            out += c;
+            continue;
+        }
+        c = raw[++i];
+        switch (c) {
+            case 'n': out += '\n'; break;
+            case 't': out += '\t'; break;
+            case 'r': out += '\r'; break;
+            case 'b': out += '\b'; break;
+            case 'f': out += '\f'; break;
+            case 'u': {
+                uint32_t code = parse_hex4(raw, i + 1);
+                i += 4;
+                // A high surrogate is followed by "\uDC00".."\uDFFF".
+                if (code >= 0xD800 && code < 0xDC00 && i + 2 < raw.size() && raw.compare(i + 1, 2, "\\u") == 0) {
+                    uint32_t low = parse_hex4(raw, i + 3);
+                    if (low >= 0xDC00 && low < 0xE000) {
+                        code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+                        i += 6;
+                    }
+                }
+                append_utf8(out, code);
+                break;
+            }
+            default: out += c; break;
+        }
+    }
+    return out;
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+// Pull-style reader over a JSON reply. It walks the text once, front to
+// back, and only looks at the values the caller asks for; everything else is
+// skipped without being copied or parsed, and no tree is ever built.
+//
+//     JsonReader reader(reply);
+//     if (!reader.enter_array()) return;
+//     while (reader.next_element()) {
+//         if (!reader.enter_object()) { reader.skip(); continue; }
+//         std::string_view key;
+//         while (reader.next_member(key)) {
+//             if (key == "pid") reader.read_int(pid);
+//             else reader.skip();
+//         }
+//     }
+//
+// Every member or element returned by next_member()/next_element() must be
+// consumed by exactly one read_*(), skip() or enter_*() call.
+class JsonReader {
+public:
+    explicit JsonReader(std::string_view text) : text(text) {}
+
+    // enter_*() consumes the opening bracket and fails, skipping the value,
+    // if the cursor is not on that container. next_*() returns false and
+    // consumes the closing bracket once the container ends. Keys are raw.
+    bool enter_object();
+    bool next_member(std::string_view& key);
+    bool enter_array();
+    bool next_element();
+
+    // On a type mismatch the value is skipped and false is returned. Strings
+    // come back as raw views with escapes left in place; see unescape().
+    bool read_int(int& out);
+    bool read_double(double& out);
+    bool read_bool(bool& out);
+    bool read_string(std::string_view& raw);
+
+    // Reads member key of the object at the cursor and skips the rest of it.
+    bool read_member_int(std::string_view key, int& out);
+
+    // Skips the value at the cursor, nested containers included.
+    bool skip();
+    // Skips the array at the cursor and returns its length, or -1.
+    int count_elements();
+
+    bool failed() const { return error; }
+
+    static std::string unescape(std::string_view raw);
+
+private:
+    std::string_view text;
+    size_t pos = 0;
+    bool error = false;
+
+    char peek();
+    bool fail();
+    bool skip_string();
+};
@@ -0,0 +1,36 @@
+#include "layer-tracker.hpp"
+
+void LayerTracker::seed(const std::vector<HyprlandSnapshot::Layer>& layers) {
+    counts.clear();
+    for (const auto& layer : layers) open(layer.name_space);
+}
+
+void LayerTracker::open(std::string_view layer) {
+    counts[std::string(layer)]++;
+}
+
+void LayerTracker::close(std::string_view layer) {
+    auto it = counts.find(std::string(layer));
+    if (it == counts.end()) return;
+    if (--it->second <= 0) counts.erase(it);
+}
+
+void LayerTracker::set(std::string_view layer, bool active) {
+    if (active) counts[std::string(layer)] = 1;
+    else counts.erase(std::string(layer));
+}
+
+bool LayerTracker::is_active(std::string_view layer) const {
+    return counts.count(std::string(layer)) != 0;
+}
+
+void LayerTracker::attach(EventDispatcher& dispatcher, ChangeCallback on_change) {
+    dispatcher.on<OpenLayerEvent>([this, on_change](const OpenLayerEvent& event) {
+        open(event.layer);
+        if (on_change) on_change(event.layer);
+    });
+    dispatcher.on<CloseLayerEvent>([this, on_change](const CloseLayerEvent& event) {
+        close(event.layer);
+        if (on_change) on_change(event.layer);
+    });
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <functional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "hyprland-events.hpp"
+#include "hyprland-ipc.hpp"
+
+// Knows which layer-shell namespaces are mapped, so is_active() never has to
+// ask the compositor. It is seeded once from a j/layers reply and then kept
+// current by openlayer/closelayer events. A namespace can be mapped more than
+// once (a bar per output), so instances are counted.
+class LayerTracker {
+public:
+    using ChangeCallback = std::function<void(std::string_view layer)>;
+
+    // Replaces the state with the given mapped layers.
+    void seed(const std::vector<HyprlandSnapshot::Layer>& layers);
+
+    void open(std::string_view layer);
+    void close(std::string_view layer);
+    // For sources that only report whether a layer is shown at all.
+    void set(std::string_view layer, bool active);
+
+    bool is_active(std::string_view layer) const;
+
+    // Keeps the tracker current from dispatcher's layer events; on_change runs
+    // after each of them.
+    void attach(EventDispatcher& dispatcher, ChangeCallback on_change = nullptr);
+
+private:
+    std::unordered_map<std::string, int> counts;
+};
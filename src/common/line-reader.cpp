@@ -0,0 +1,54 @@
+#include "line-reader.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <unistd.h>
+
+namespace {
+
+// Below this much free space, the unread tail is compacted before reading.
+const size_t MIN_READ = 4096;
+
+}
+
+LineReader::LineReader(size_t capacity) : buffer(capacity < MIN_READ ? MIN_READ : capacity) {}
+
+void LineReader::make_room() {
+    if (head == tail) {
+        head = tail = scanned = 0;
+        return;
+    }
+    if (buffer.size() - tail >= MIN_READ) return;
+
+    if (head > 0) {
+        memmove(buffer.data(), buffer.data() + head, tail - head);
+        tail -= head;
+        head = 0;
+    }
+    // A single line longer than the buffer grows it instead of being split.
+    if (buffer.size() - tail < MIN_READ) buffer.resize(buffer.size() * 2);
+}
+
+ssize_t LineReader::fill(int fd) {
+    make_room();
+    while (true) {
+        ssize_t bytes_read = read(fd, buffer.data() + tail, buffer.size() - tail);
+        if (bytes_read == -1 && errno == EINTR) continue;
+        if (bytes_read > 0) tail += bytes_read;
+        return bytes_read;
+    }
+}
+
+bool LineReader::next_line(std::string_view& line) {
+    const char* start = buffer.data() + head;
+    const char* newline = static_cast<const char*>(memchr(start + scanned, '\n', tail - head - scanned));
+    if (!newline) {
+        scanned = tail - head;
+        return false;
+    }
+
+    line = std::string_view(start, newline - start);
+    head += line.size() + 1;
+    scanned = 0;
+    return true;
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstddef>
+#include <string_view>
+#include <sys/types.h>
+#include <vector>
+
+// Frames newline-terminated records, such as socket2 events, read from a file
+// descriptor. Reads land directly in one reusable buffer and lines are handed
+// out as views into it, so framing never copies or allocates per line. Only
+// an incomplete trailing line is moved back to the front to make room.
+class LineReader {
+public:
+    explicit LineReader(size_t capacity = 65536);
+
+    // Reads once from fd into the free space and returns the read() result:
+    // the byte count, 0 on EOF, or -1 with errno set (EAGAIN when a
+    // non-blocking fd is drained).
+    ssize_t fill(int fd);
+
+    // Stores the next complete line, without its '\n', in line. Returns false
+    // once no complete line is buffered. Views stay valid until the next fill().
+    bool next_line(std::string_view& line);
+
+private:
+    void make_room();
+
+    std::vector<char> buffer;
+    size_t head = 0;
+    size_t tail = 0;
+    size_t scanned = 0;
+};
@@ -0,0 +1,138 @@
+#include "process-supervisor.hpp"
+
+#include <cctype>
+#include <cerrno>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <utility>
+
+// Both calls share these numbers on every architecture since Linux 5.3.
+#ifndef SYS_pidfd_open
+#define SYS_pidfd_open 434
+#endif
+#ifndef SYS_pidfd_send_signal
+#define SYS_pidfd_send_signal 424
+#endif
+
+namespace {
+
+int pidfd_open(pid_t pid) {
+    return static_cast<int>(syscall(SYS_pidfd_open, pid, 0));
+}
+
+int pidfd_send_signal(int fd, int signo) {
+    return static_cast<int>(syscall(SYS_pidfd_send_signal, fd, signo, nullptr, 0));
+}
+
+pid_t find_by_name(const std::string& name) {
+    DIR* dir = opendir("/proc");
+    if (!dir) return -1;
+
+    pid_t found = -1;
+    char path[288];
+    char comm[64];
+    struct dirent* ent;
+    while (found == -1 && (ent = readdir(dir)) != nullptr) {
+        if (!isdigit(static_cast<unsigned char>(ent->d_name[0]))) continue;
+        snprintf(path, sizeof(path), "/proc/%s/comm", ent->d_name);
+        int fd = open(path, O_RDONLY | O_CLOEXEC);
+        if (fd == -1) continue;
+        ssize_t len = read(fd, comm, sizeof(comm) - 1);
+        close(fd);
+        if (len <= 0) continue;
+        if (comm[len - 1] == '\n') len--;
+        if (name.compare(0, std::string::npos, comm, len) == 0) found = atoi(ent->d_name);
+    }
+    closedir(dir);
+    return found;
+}
+
+}
+
+ProcessSupervisor::ProcessSupervisor(EventLoop& loop, std::string program)
+    : loop(loop), program(std::move(program)) {}
+
+ProcessSupervisor::~ProcessSupervisor() {
+    if (pidfd != -1) close(pidfd);
+}
+
+void ProcessSupervisor::watch(pid_t pid, bool child) {
+    current_pid = pid;
+    is_child = child;
+
+    pidfd = pidfd_open(pid);
+    if (pidfd != -1) {
+        // A pidfd turns readable once the process has exited.
+        loop.add_fd(pidfd, EPOLLIN, [this](uint32_t) {
+            int status = -1;
+            if (is_child && waitpid(current_pid, &status, WNOHANG) != current_pid) status = -1;
+            exited(status);
+        });
+        return;
+    }
+
+    // Kernels without pidfds: our own child is still reported through
+    // SIGCHLD; an adopted process is only noticed when signal() fails.
+    if (child) {
+        loop.watch_child(pid, [this, pid](int status) {
+            if (current_pid == pid) exited(status);
+        });
+    }
+}
+
+void ProcessSupervisor::release() {
+    if (pidfd != -1) {
+        loop.remove_fd(pidfd);
+        close(pidfd);
+        pidfd = -1;
+    }
+    current_pid = -1;
+    is_child = false;
+}
+
+void ProcessSupervisor::exited(int status) {
+    release();
+    if (on_exit) on_exit(status);
+}
+
+pid_t ProcessSupervisor::adopt() {
+    if (running()) return current_pid;
+
+    pid_t pid = find_by_name(program);
+    if (pid <= 0) return -1;
+    watch(pid, false);
+    return current_pid;
+}
+
+pid_t ProcessSupervisor::spawn() {
+    if (running()) release();
+
+    pid_t pid = fork();
+    if (pid == -1) return -1;
+    if (pid == 0) {
+        loop.unblock_signals();
+        char* args[] = {const_cast<char*>(program.c_str()), nullptr};
+        execvp(args[0], args);
+        _exit(127);
+    }
+    watch(pid, true);
+    return pid;
+}
+
+bool ProcessSupervisor::signal(int signo) {
+    if (!running()) return false;
+
+    int result = (pidfd != -1) ? pidfd_send_signal(pidfd, signo) : kill(current_pid, signo);
+    if (result == 0) return true;
+    // Without a pidfd this is the only way an adopted process is seen to go.
+    if (errno == ESRCH && pidfd == -1 && !is_child) exited(-1);
+    return false;
+}
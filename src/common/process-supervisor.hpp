@@ -0,0 +1,48 @@
+#pragma once
+
+#include <functional>
+#include <string>
+#include <sys/types.h>
+
+#include "event-loop.hpp"
+
+// Watches one instance of a program, such as Waybar, through a pidfd. Exit
+// is reported by the event loop, and signals go through the pidfd, so they
+// can never reach a recycled pid. /proc is only scanned when adopt() is
+// called explicitly.
+class ProcessSupervisor {
+public:
+    // status is the wait status for an instance we spawned, -1 otherwise.
+    using ExitCallback = std::function<void(int status)>;
+
+    ProcessSupervisor(EventLoop& loop, std::string program);
+    ~ProcessSupervisor();
+    ProcessSupervisor(const ProcessSupervisor&) = delete;
+    ProcessSupervisor& operator=(const ProcessSupervisor&) = delete;
+
+    // Looks for a running instance with one /proc scan and watches it.
+    // Returns its pid or -1.
+    pid_t adopt();
+    // Starts a new instance and watches it. Returns its pid or -1.
+    pid_t spawn();
+
+    bool running() const { return current_pid > 0; }
+    pid_t pid() const { return current_pid; }
+
+    bool signal(int signo);
+
+    // Runs once the watched instance has exited (and been reaped if it was
+    // ours); running() is already false by then.
+    ExitCallback on_exit;
+
+private:
+    EventLoop& loop;
+    std::string program;
+    pid_t current_pid = -1;
+    int pidfd = -1;
+    bool is_child = false;
+
+    void watch(pid_t pid, bool child);
+    void release();
+    void exited(int status);
+};
@@ -1,107 +1,147 @@
 #include <iostream>
+#include <fstream>
 #include <string>
+#include <string_view>
 #include <vector>
-#include <cstring>
 #include <unistd.h>
 #include <sys/socket.h>
-#include <sys/un.h>
-#include <memory>
 #include <cstdlib>
-#include <cstdio>
 #include <algorithm>
+#include "hyprland-ipc.hpp"
+#include "event-loop.hpp"
+#include "event-socket.hpp"
+#include "line-reader.hpp"
+#include "hyprland-events.hpp"
 
-const std::vector<int> FORBIDDEN_IDS = {1}; 
+HyprlandIPC ipc;
 
-struct PipeDeleter {
-    void operator()(FILE* stream) const { if (stream) pclose(stream); }
-};
+// Move decisions waiting for the next flush, sent together as one [[BATCH]].
+std::vector<std::string> pending_moves;
 
-std::string exec(const char* cmd) {
-    char buffer[1024];
-    std::string result = "";
-    std::unique_ptr<FILE, PipeDeleter> pipe(popen(cmd, "r"));
-    if (!pipe) return "";
-    while (fgets(buffer, sizeof(buffer), pipe.get()) != nullptr) {
-        result += buffer;
+// Forbidden workspaces are matched by name, which is also the id for
+// numeric workspaces, so "1" covers both openwindow and movewindowv2.
+std::vector<std::string> forbidden_workspaces;
+
+std::string trim(const std::string& str) {
+    size_t first = str.find_first_not_of(" \t");
+    if (first == std::string::npos) return "";
+    size_t last = str.find_last_not_of(" \t\r");
+    return str.substr(first, last - first + 1);
+}
+
+std::string default_config_path() {
+    const char* xdg_env = std::getenv("XDG_CONFIG_HOME");
+    if (xdg_env && *xdg_env != '\0') return std::string(xdg_env) + "/hypr/user/configs/eject-forbidden.conf";
+
+    const char* home_env = std::getenv("HOME");
+    if (!home_env) return "";
+    return std::string(home_env) + "/.config/hypr/user/configs/eject-forbidden.conf";
+}
+
+// Reads "workspace = ID" lines; without a usable file, workspace 1 stays forbidden.
+void load_config(const std::string& path) {
+    forbidden_workspaces.clear();
+    std::ifstream file(path);
+
+    std::string line;
+    while (file.is_open() && std::getline(file, line)) {
+        line = trim(line.substr(0, line.find('#')));
+        size_t eq = line.find('=');
+        if (eq == std::string::npos || trim(line.substr(0, eq)) != "workspace") continue;
+
+        std::string ws = trim(line.substr(eq + 1));
+        if (!ws.empty()) forbidden_workspaces.push_back(ws);
     }
-    return result;
+
+    if (forbidden_workspaces.empty()) forbidden_workspaces.push_back("1");
 }
 
-int get_active_window_workspace() {
-    std::string json = exec("hyprctl -j activewindow");
-    
-    size_t ws_pos = json.find("\"workspace\":");
-    if (ws_pos == std::string::npos) return -999;
-    
-    size_t id_pos = json.find("\"id\":", ws_pos);
-    if (id_pos == std::string::npos) return -999;
-    
-    size_t start = id_pos + 5; 
-    while (start < json.length() && !isdigit(json[start]) && json[start] != '-') start++;
-    size_t end = start;
-    while (end < json.length() && (isdigit(json[end]) || json[end] == '-')) end++;
-    
-    try {
-        return std::stoi(json.substr(start, end - start));
-    } catch (...) {
-        return -999;
+// Queues a move for the window named by ADDR when WS_NAME is forbidden. The
+// address comes straight from the event, so unfocused windows are handled too.
+void check_and_eject(std::string_view addr, std::string_view ws_name) {
+    if (addr.empty()) return;
+    if (std::find(forbidden_workspaces.begin(), forbidden_workspaces.end(), ws_name) == forbidden_workspaces.end()) return;
+
+    std::string move = "movetoworkspacesilent r+1,address:0x";
+    move.append(addr);
+    if (std::find(pending_moves.begin(), pending_moves.end(), move) == pending_moves.end()) {
+        pending_moves.push_back(std::move(move));
     }
 }
 
-void check_and_eject() {
-    int ws_id = get_active_window_workspace();
-    if (ws_id == -999) return;
+void flush_moves() {
+    if (pending_moves.size() == 1) {
+        ipc.dispatch(pending_moves.front());
+    } else {
+        ipc.dispatch_batch(pending_moves);
+    }
+    pending_moves.clear();
+}
+
+void print_usage() {
+    std::cerr << "Usage: eject-forbidden [--batch-ms N] [CONFIG]\n"
+              << "  --batch-ms N  gather moves for up to N ms before dispatching them\n"
+              << "                (default: 0, one batch per socket read)\n"
+              << "  CONFIG        forbidden workspace list\n"
+              << "                (default: $XDG_CONFIG_HOME/hypr/user/configs/eject-forbidden.conf)\n";
+}
 
-    for (int forbidden : FORBIDDEN_IDS) {
-        if (ws_id == forbidden) {
-            system("hyprctl dispatch movetoworkspacesilent r+1 > /dev/null");
-            return;
+int main(int argc, char* argv[]) {
+    std::string config_path = default_config_path();
+    int batch_ms = 0;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--batch-ms" && i + 1 < argc) {
+            batch_ms = std::clamp(atoi(argv[++i]), 0, 1000);
+        } else if (arg.rfind("-", 0) != 0) {
+            config_path = arg;
+        } else {
+            print_usage();
+            return 1;
         }
     }
-}
 
-int main() {
-    const char* runtime_dir = getenv("XDG_RUNTIME_DIR");
-    const char* signature = getenv("HYPRLAND_INSTANCE_SIGNATURE");
-    if (!runtime_dir || !signature) return 1;
+    if (!ipc.available()) return 1;
 
-    std::string socket_path = std::string(runtime_dir) + "/hypr/" + std::string(signature) + "/.socket2.sock";
+    load_config(config_path);
 
-    struct sockaddr_un addr;
-    int sfd = socket(AF_UNIX, SOCK_STREAM, 0);
+    int sfd = ipc.connect_events(SOCK_NONBLOCK);
     if (sfd == -1) return 1;
 
-    memset(&addr, 0, sizeof(struct sockaddr_un));
-    addr.sun_family = AF_UNIX;
-    strncpy(addr.sun_path, socket_path.c_str(), sizeof(addr.sun_path) - 1);
+    EventLoop loop;
+    LineReader events;
+    EventDispatcher dispatcher;
+    dispatcher.on<OpenWindowEvent>([](const OpenWindowEvent& event) {
+        check_and_eject(event.address, event.workspace);
+    });
+    dispatcher.on<MoveWindowV2Event>([](const MoveWindowV2Event& event) {
+        check_and_eject(event.address, event.workspace);
+    });
 
-    if (connect(sfd, (struct sockaddr *) &addr, sizeof(struct sockaddr_un)) == -1) {
-        close(sfd);
-        return 1;
-    }
+    // With a batch window, the first queued move arms a one-shot timer so no
+    // move waits longer than batch_ms; otherwise each drained read is a batch.
+    bool flush_armed = false;
+    int flush_timer = loop.add_timer(0, false, [&]() {
+        flush_armed = false;
+        flush_moves();
+    });
 
-    char buffer[1024];
-    std::string pending_data = "";
-    
-    while (true) {
-        ssize_t num_read = read(sfd, buffer, sizeof(buffer) - 1);
-        if (num_read > 0) {
-            buffer[num_read] = '\0';
-            pending_data += buffer;
-            
-            size_t pos = 0;
-            while ((pos = pending_data.find('\n')) != std::string::npos) {
-                std::string line = pending_data.substr(0, pos);
-                pending_data.erase(0, pos + 1);
-                
-                if (line.find("openwindow") == 0 || line.find("movewindow") == 0) {
-                    check_and_eject();
-                }
-            }
-        } else {
-             break;
+    auto on_batch = [&]() {
+        if (pending_moves.empty()) return;
+        if (batch_ms == 0) {
+            flush_moves();
+        } else if (!flush_armed) {
+            flush_armed = true;
+            loop.set_timer(flush_timer, batch_ms, false);
         }
-    }
+    };
+    add_event_socket(loop, sfd, events, dispatcher, on_batch, [&loop]() {
+        flush_moves();
+        loop.stop();
+    });
+
+    loop.run();
 
     close(sfd);
     return 0;
@@ -1,137 +1,1443 @@
 #include <iostream>
+#include <fstream>
 #include <vector>
 #include <string>
+#include <string_view>
+#include <charconv>
 #include <cstring>
+#include <cstdint>
+#include <cerrno>
+#include <csignal>
+#include <memory>
 #include <unistd.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <functional>
+#include <sys/stat.h>
+#include <sys/epoll.h>
 #include <sys/socket.h>
-#include <sys/un.h>
 #include <sys/resource.h>
-#include <memory>
+#include <sys/syscall.h>
+#include <sched.h>
+#include <linux/ioprio.h>
+#include <linux/capability.h>
+#include <linux/netlink.h>
+#include <linux/connector.h>
+#include <linux/cn_proc.h>
 #include <cstdlib>
 #include <cstdio>
 #include <algorithm>
 #include <map>
+#include <unordered_map>
+#include <unordered_set>
+#include <regex>
+#include "hyprland-ipc.hpp"
+#include "event-loop.hpp"
+#include "event-socket.hpp"
+#include "file-watch.hpp"
+#include "line-reader.hpp"
+#include "hyprland-events.hpp"
+#include "json-reader.hpp"
+
+HyprlandIPC ipc;
+
+bool write_file(const std::string& path, const std::string& value) {
+    int fd = open(path.c_str(), O_WRONLY | O_CLOEXEC);
+    if (fd == -1) return false;
+    bool ok = write(fd, value.c_str(), value.length()) == (ssize_t)value.length();
+    close(fd);
+    return ok;
+}
+
+// Collects pid and all of its current descendants from /proc/<pid>/task/*/children.
+void collect_process_tree(int pid, std::vector<int>& out) {
+    out.push_back(pid);
+    std::string task_dir = "/proc/" + std::to_string(pid) + "/task";
+    DIR* dir = opendir(task_dir.c_str());
+    if (!dir) return;
+    struct dirent* ent;
+    while ((ent = readdir(dir)) != nullptr) {
+        if (!isdigit(ent->d_name[0])) continue;
+        std::ifstream children_file(task_dir + "/" + ent->d_name + "/children");
+        int child;
+        while (children_file >> child) collect_process_tree(child, out);
+    }
+    closedir(dir);
+}
+
+bool has_net_admin() {
+    std::ifstream status_file("/proc/self/status");
+    std::string line;
+    while (std::getline(status_file, line)) {
+        if (line.rfind("CapEff:", 0) != 0) continue;
+        unsigned long long caps = strtoull(line.c_str() + 7, nullptr, 16);
+        return (caps >> CAP_NET_ADMIN) & 1;
+    }
+    return false;
+}
+
+// Follows the descendants of every managed client pid, so processes forked
+// after a window was mapped (browser renderers, builds started in a terminal)
+// get the client's priority right away. Uses the kernel proc connector when
+// the daemon may listen to it (CAP_NET_ADMIN), otherwise a periodic /proc scan.
+class ProcessTracker {
+private:
+    int netlink_fd = -1;
+    std::unordered_map<int, int> owner;
+    std::unordered_map<int, std::unordered_set<int>> members;
+
+    // Moves pid into root's tree, out of the tree that held it before.
+    // Returns false if it was already there.
+    bool assign(int root, int pid) {
+        auto it = owner.find(pid);
+        if (it != owner.end()) {
+            if (it->second == root) return false;
+            auto group = members.find(it->second);
+            if (group != members.end()) group->second.erase(pid);
+            it->second = root;
+        } else {
+            owner.emplace(pid, root);
+        }
+        members[root].insert(pid);
+        return true;
+    }
+
+    // A client root keeps its own pid even when it was started from inside
+    // another client's tree.
+    void add_member(int root, int pid) {
+        if (pid != root && members.count(pid)) return;
+        if (!assign(root, pid)) return;
+        if (on_new_member) on_new_member(root, pid);
+    }
+
+    void remove_pid(int pid) {
+        auto it = owner.find(pid);
+        if (it == owner.end()) return;
+        auto group = members.find(it->second);
+        if (group != members.end()) group->second.erase(pid);
+        owner.erase(it);
+    }
+
+    void handle_proc_event(const proc_event& ev) {
+        switch (ev.what) {
+        case proc_event::PROC_EVENT_FORK: {
+            const auto& fork = ev.event_data.fork;
+            if (fork.child_pid != fork.child_tgid) break;
+            auto parent = owner.find(fork.parent_tgid);
+            if (parent != owner.end()) add_member(parent->second, fork.child_tgid);
+            break;
+        }
+        case proc_event::PROC_EVENT_EXEC: {
+            auto it = owner.find(ev.event_data.exec.process_tgid);
+            if (it != owner.end() && on_new_member) on_new_member(it->second, it->first);
+            break;
+        }
+        case proc_event::PROC_EVENT_EXIT: {
+            const auto& exit = ev.event_data.exit;
+            if (exit.process_pid == exit.process_tgid) remove_pid(exit.process_tgid);
+            break;
+        }
+        default:
+            break;
+        }
+    }
+
+public:
+    // Called for each process that joins a managed tree, and again after it
+    // execs, with the managed client pid it belongs to.
+    std::function<void(int root, int pid)> on_new_member;
+
+    ~ProcessTracker() {
+        if (netlink_fd != -1) close(netlink_fd);
+    }
+
+    bool open_connector() {
+        if (!has_net_admin()) return false;
+
+        netlink_fd = socket(PF_NETLINK, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, NETLINK_CONNECTOR);
+        if (netlink_fd == -1) return false;
+
+        sockaddr_nl sa{};
+        sa.nl_family = AF_NETLINK;
+        sa.nl_groups = CN_IDX_PROC;
+        sa.nl_pid = 0;
+        if (bind(netlink_fd, (struct sockaddr*)&sa, sizeof(sa)) == -1) {
+            close(netlink_fd);
+            netlink_fd = -1;
+            return false;
+        }
+
+        alignas(nlmsghdr) char request[NLMSG_SPACE(sizeof(cn_msg) + sizeof(proc_cn_mcast_op))] = {};
+        nlmsghdr* header = (nlmsghdr*)request;
+        header->nlmsg_len = NLMSG_LENGTH(sizeof(cn_msg) + sizeof(proc_cn_mcast_op));
+        header->nlmsg_type = NLMSG_DONE;
+        cn_msg* message = (cn_msg*)NLMSG_DATA(header);
+        message->id.idx = CN_IDX_PROC;
+        message->id.val = CN_VAL_PROC;
+        message->len = sizeof(proc_cn_mcast_op);
+        proc_cn_mcast_op op = PROC_CN_MCAST_LISTEN;
+        memcpy(message->data, &op, sizeof(op));
+
+        if (send(netlink_fd, header, header->nlmsg_len, 0) == -1) {
+            close(netlink_fd);
+            netlink_fd = -1;
+            return false;
+        }
+        return true;
+    }
+
+    int fd() const { return netlink_fd; }
+
+    // Drains pending connector messages. Returns false if events were lost
+    // (receive buffer overrun), in which case the caller should rescan().
+    bool handle_connector_events() {
+        alignas(nlmsghdr) char buffer[8192];
+        while (true) {
+            ssize_t len = recv(netlink_fd, buffer, sizeof(buffer), 0);
+            if (len == -1) {
+                if (errno == EINTR) continue;
+                return errno != ENOBUFS;
+            }
+            if (len == 0) return true;
+
+            for (nlmsghdr* header = (nlmsghdr*)buffer; NLMSG_OK(header, (size_t)len); header = NLMSG_NEXT(header, len)) {
+                if (header->nlmsg_type == NLMSG_ERROR || header->nlmsg_type == NLMSG_NOOP) continue;
+                cn_msg* message = (cn_msg*)NLMSG_DATA(header);
+                if (message->id.idx != CN_IDX_PROC || message->id.val != CN_VAL_PROC) continue;
+                handle_proc_event(*(proc_event*)message->data);
+            }
+        }
+    }
+
+    // Rebuilds the trees from a full /proc walk: drops exited pids and adopts
+    // any process whose ancestor chain reaches a managed pid.
+    void rescan() {
+        std::unordered_map<int, int> parent_of;
+        DIR* dir = opendir("/proc");
+        if (!dir) return;
+        struct dirent* ent;
+        while ((ent = readdir(dir)) != nullptr) {
+            if (!isdigit(ent->d_name[0])) continue;
+            std::ifstream stat_file(std::string("/proc/") + ent->d_name + "/stat");
+            std::string stat;
+            if (!std::getline(stat_file, stat)) continue;
+            size_t comm_end = stat.rfind(')');
+            if (comm_end == std::string::npos || comm_end + 4 >= stat.length()) continue;
+            parent_of[atoi(ent->d_name)] = atoi(stat.c_str() + comm_end + 4);
+        }
+        closedir(dir);
+
+        std::vector<int> exited;
+        for (const auto& entry : owner) {
+            if (parent_of.count(entry.first) == 0) exited.push_back(entry.first);
+        }
+        for (int pid : exited) remove_pid(pid);
+
+        std::vector<int> chain;
+        for (const auto& entry : parent_of) {
+            if (owner.count(entry.first)) continue;
+            chain.clear();
+            int current = entry.first;
+            int root = 0;
+            while (current > 1) {
+                auto known = owner.find(current);
+                if (known != owner.end()) {
+                    root = known->second;
+                    break;
+                }
+                chain.push_back(current);
+                auto parent = parent_of.find(current);
+                if (parent == parent_of.end()) break;
+                current = parent->second;
+            }
+            if (root == 0) continue;
+            // Adopt from the top of the chain down so parents precede children.
+            for (auto it = chain.rbegin(); it != chain.rend(); ++it) add_member(root, *it);
+        }
+    }
+
+    // A client started from another client (an app launched from a terminal,
+    // a game from its launcher) takes its subtree out of the launcher's tree.
+    // Parts of that subtree owned by clients further down stay with them.
+    // Returns the client the root was taken from, or 0.
+    int manage(int root) {
+        if (members.count(root)) return 0;
+        auto previous = owner.find(root);
+        int from = (previous != owner.end()) ? previous->second : 0;
+        members[root];
+        std::vector<int> tree;
+        collect_process_tree(root, tree);
+        for (int pid : tree) {
+            auto it = owner.find(pid);
+            if (it == owner.end() || it->second == from) assign(root, pid);
+        }
+        return from;
+    }
 
-struct PipeDeleter {
-    void operator()(FILE* stream) const { if (stream) pclose(stream); }
+    void unmanage(int root) {
+        auto group = members.find(root);
+        if (group == members.end()) return;
+        for (int pid : group->second) {
+            auto it = owner.find(pid);
+            if (it != owner.end() && it->second == root) owner.erase(it);
+        }
+        members.erase(group);
+    }
+
+    const std::unordered_set<int>& members_of(int root) const {
+        static const std::unordered_set<int> none;
+        auto group = members.find(root);
+        return (group != members.end()) ? group->second : none;
+    }
 };
 
-std::string exec(const char* cmd) {
-    char buffer[4096];
-    std::string result = "";
-    std::unique_ptr<FILE, PipeDeleter> pipe(popen(cmd, "r"));
-    if (!pipe) return "";
-    while (fgets(buffer, sizeof(buffer), pipe.get()) != nullptr) {
-        result += buffer;
+ProcessTracker process_tracker;
+
+// A scheduling profile applied to every task of a client's process tree.
+struct SchedProfile {
+    int nice = 0;
+    int policy = SCHED_OTHER;
+    int ioprio = IOPRIO_PRIO_VALUE(IOPRIO_CLASS_NONE, 0);
+    bool pinned = false;
+    cpu_set_t cpus;
+
+    bool operator==(const SchedProfile& other) const {
+        return nice == other.nice && policy == other.policy && ioprio == other.ioprio &&
+               pinned == other.pinned && (!pinned || CPU_EQUAL(&cpus, &other.cpus));
     }
-    return result;
+    bool operator!=(const SchedProfile& other) const { return !(*this == other); }
+};
+
+// What a process has before hypr-nice touches it. Profiles are applied as a
+// change from it, so settings a profile does not ask for (chrt, taskset,
+// ionice, rtkit) are left alone.
+const SchedProfile NEUTRAL_PROFILE{};
+
+// Affinity restored for profiles that do not pin, captured at startup.
+cpu_set_t default_cpus;
+
+// Parses "0-3,6,8-11" into a cpu set.
+bool parse_cpu_list(const std::string& text, cpu_set_t& set) {
+    CPU_ZERO(&set);
+    size_t start = 0;
+    while (start < text.length()) {
+        size_t comma = text.find(',', start);
+        std::string range = text.substr(start, comma == std::string::npos ? std::string::npos : comma - start);
+        // strtol rather than atoi, so "a-z" or "3x" fail instead of naming CPU 0.
+        const char* cursor = range.c_str();
+        char* end;
+        if (!isdigit((unsigned char)*cursor)) return false;
+        long first = strtol(cursor, &end, 10);
+        long last = first;
+        if (*end == '-') {
+            cursor = end + 1;
+            if (!isdigit((unsigned char)*cursor)) return false;
+            last = strtol(cursor, &end, 10);
+        }
+        if (*end != '\0') return false;
+        if (last < first || last >= CPU_SETSIZE) return false;
+        for (int cpu = first; cpu <= last; ++cpu) CPU_SET(cpu, &set);
+        if (comma == std::string::npos) break;
+        start = comma + 1;
+    }
+    return CPU_COUNT(&set) > 0;
 }
 
-int get_json_int(const std::string& json, const std::string& key) {
-    std::string search = "\"" + key + "\":";
-    size_t pos = json.find(search);
-    if (pos == std::string::npos) return -999;
-    
-    size_t start = pos + search.length();
-    while (start < json.length() && (json[start] == ' ' || json[start] == '\n')) start++;
-    
-    size_t end = start;
-    while (end < json.length() && (isdigit(json[end]) || json[end] == '-')) end++;
-    
-    try {
-        return std::stoi(json.substr(start, end - start));
-    } catch (...) {
-        return -999;
+// Parses "nice:N sched:other|batch|idle ioprio:none|idle|be/N|rt/N cpus:LIST".
+bool parse_profile(const std::string& spec, SchedProfile& profile) {
+    size_t start = 0;
+    while (start < spec.length()) {
+        size_t end = spec.find(' ', start);
+        if (end == std::string::npos) end = spec.length();
+        std::string token = spec.substr(start, end - start);
+        start = end + 1;
+        if (token.empty()) continue;
+
+        size_t colon = token.find(':');
+        if (colon == std::string::npos) return false;
+        std::string key = token.substr(0, colon);
+        std::string value = token.substr(colon + 1);
+
+        if (key == "nice") {
+            profile.nice = std::clamp(atoi(value.c_str()), -20, 19);
+        } else if (key == "sched") {
+            if (value == "other") profile.policy = SCHED_OTHER;
+            else if (value == "batch") profile.policy = SCHED_BATCH;
+            else if (value == "idle") profile.policy = SCHED_IDLE;
+            else return false;
+        } else if (key == "ioprio") {
+            int level = (value.length() > 3) ? std::clamp(atoi(value.c_str() + 3), 0, 7) : 4;
+            if (value == "none") profile.ioprio = IOPRIO_PRIO_VALUE(IOPRIO_CLASS_NONE, 0);
+            else if (value == "idle") profile.ioprio = IOPRIO_PRIO_VALUE(IOPRIO_CLASS_IDLE, 0);
+            else if (value.rfind("be", 0) == 0) profile.ioprio = IOPRIO_PRIO_VALUE(IOPRIO_CLASS_BE, level);
+            else if (value.rfind("rt", 0) == 0) profile.ioprio = IOPRIO_PRIO_VALUE(IOPRIO_CLASS_RT, level);
+            else return false;
+        } else if (key == "cpus") {
+            if (!parse_cpu_list(value, profile.cpus)) return false;
+            profile.pinned = true;
+        } else {
+            return false;
+        }
     }
+    return true;
 }
 
-std::map<int, int> pid_priority_cache;
-
-void update_priorities() {
-    std::string ws_out = exec("hyprctl -j activeworkspace");
-    int active_id = get_json_int(ws_out, "id");
-    if (active_id == -999) return;
-
-    std::string clients_out = exec("hyprctl -j clients");
-    
-    size_t cursor = 0;
-    while ((cursor = clients_out.find("{", cursor)) != std::string::npos) {
-        int depth = 1;
-        size_t end = cursor + 1;
-        while (end < clients_out.length() && depth > 0) {
-            if (clients_out[end] == '{') depth++;
-            else if (clients_out[end] == '}') depth--;
-            end++;
-        }
-        
-        std::string obj = clients_out.substr(cursor, end - cursor);
-        
-        int pid = get_json_int(obj, "pid");
-        int ws_id = -999;
-        size_t ws_block_pos = obj.find("\"workspace\":");
-        if (ws_block_pos != std::string::npos) {
-            ws_id = get_json_int(obj.substr(ws_block_pos), "id");
-        }
-
-        if (pid > 0 && ws_id != -999) {
-            int target_prio = (ws_id == active_id) ? 0 : 19;
-            
-            if (pid_priority_cache.find(pid) == pid_priority_cache.end() || pid_priority_cache[pid] != target_prio) {
-                setpriority(PRIO_PROCESS, pid, target_prio);
-                pid_priority_cache[pid] = target_prio;
+// Applies profile to every task of pid, skipping fields that already match
+// previous (the profile the process had before). Realtime threads keep their
+// policy.
+void apply_profile_to_process(int pid, const SchedProfile& profile, const SchedProfile& previous) {
+    std::string task_dir = "/proc/" + std::to_string(pid) + "/task";
+    DIR* dir = opendir(task_dir.c_str());
+    if (!dir) return;
+    struct dirent* ent;
+    while ((ent = readdir(dir)) != nullptr) {
+        if (!isdigit(ent->d_name[0])) continue;
+        int tid = atoi(ent->d_name);
+
+        if (previous.policy != profile.policy) {
+            int current = sched_getscheduler(tid);
+            if (current != SCHED_FIFO && current != SCHED_RR) {
+                sched_param param{};
+                sched_setscheduler(tid, profile.policy, &param);
             }
         }
-        cursor = end;
+        // Nice values are per thread on Linux; threads created later inherit
+        // them (and the other attributes) from their creator.
+        if (previous.nice != profile.nice) setpriority(PRIO_PROCESS, tid, profile.nice);
+        if (previous.ioprio != profile.ioprio) syscall(SYS_ioprio_set, IOPRIO_WHO_PROCESS, tid, profile.ioprio);
+        if (previous.pinned != profile.pinned || (profile.pinned && !CPU_EQUAL(&previous.cpus, &profile.cpus))) {
+            sched_setaffinity(tid, sizeof(cpu_set_t), profile.pinned ? &profile.cpus : &default_cpus);
+        }
     }
+    closedir(dir);
 }
 
-int main() {
-    const char* runtime_dir = getenv("XDG_RUNTIME_DIR");
-    const char* signature = getenv("HYPRLAND_INSTANCE_SIGNATURE");
-    if (!runtime_dir || !signature) return 1;
+struct Rule {
+    int foreground_profile;
+    int background_profile;
+    bool match_class = false;
+    bool match_title = false;
+    bool match_workspace = false;
+    std::regex class_re;
+    std::regex title_re;
+    std::regex workspace_re;
+};
 
-    std::string socket_path = std::string(runtime_dir) + "/hypr/" + std::string(signature) + "/.socket2.sock";
+// Window rules from hypr-nice.conf, compiled once per (re)load:
+//
+//   profile = NAME, nice:N sched:other|batch|idle ioprio:none|idle|be/N|rt/N cpus:LIST
+//   rule = FOREGROUND_PROFILE, BACKGROUND_PROFILE, class:REGEX, title:REGEX, workspace:REGEX
+//
+// The first matching rule wins. Windows without a rule use the built-in
+// "foreground" (nice 0) and "background" (nice 19) profiles, which the file
+// may redefine.
+class RuleSet {
+private:
+    std::vector<SchedProfile> profiles;
+    std::unordered_map<std::string, int> profile_index;
+    std::vector<Rule> rules;
 
-    struct sockaddr_un addr;
-    int sfd = socket(AF_UNIX, SOCK_STREAM, 0);
-    if (sfd == -1) return 1;
+    static std::string trim(const std::string& str) {
+        size_t first = str.find_first_not_of(" \t");
+        if (first == std::string::npos) return "";
+        size_t last = str.find_last_not_of(" \t");
+        return str.substr(first, last - first + 1);
+    }
 
-    memset(&addr, 0, sizeof(struct sockaddr_un));
-    addr.sun_family = AF_UNIX;
-    strncpy(addr.sun_path, socket_path.c_str(), sizeof(addr.sun_path) - 1);
+    void define_profile(const std::string& name, const SchedProfile& profile) {
+        auto it = profile_index.find(name);
+        if (it != profile_index.end()) {
+            profiles[it->second] = profile;
+            return;
+        }
+        profile_index[name] = profiles.size();
+        profiles.push_back(profile);
+    }
 
-    if (connect(sfd, (struct sockaddr *) &addr, sizeof(struct sockaddr_un)) == -1) {
-        close(sfd);
-        return 1;
+    bool parse_rule(const std::string& value, Rule& rule) {
+        std::vector<std::string> fields;
+        size_t start = 0;
+        while (true) {
+            size_t comma = value.find(',', start);
+            fields.push_back(trim(value.substr(start, comma == std::string::npos ? std::string::npos : comma - start)));
+            if (comma == std::string::npos) break;
+            start = comma + 1;
+        }
+        if (fields.size() < 3) return false;
+
+        auto fg = profile_index.find(fields[0]);
+        auto bg = profile_index.find(fields[1]);
+        if (fg == profile_index.end() || bg == profile_index.end()) return false;
+        rule.foreground_profile = fg->second;
+        rule.background_profile = bg->second;
+
+        // A field that does not start with a matcher key continues the
+        // previous regex, so patterns like "a{2,3}" survive the comma split.
+        std::string key, pattern;
+        auto flush = [&]() -> bool {
+            if (key.empty()) return true;
+            std::regex re(pattern, std::regex::ECMAScript | std::regex::optimize);
+            if (key == "class") { rule.class_re = re; rule.match_class = true; }
+            else if (key == "title") { rule.title_re = re; rule.match_title = true; }
+            else if (key == "workspace") { rule.workspace_re = re; rule.match_workspace = true; }
+            return true;
+        };
+        for (size_t i = 2; i < fields.size(); ++i) {
+            size_t colon = fields[i].find(':');
+            std::string field_key = (colon == std::string::npos) ? "" : fields[i].substr(0, colon);
+            if (field_key == "class" || field_key == "title" || field_key == "workspace") {
+                flush();
+                key = field_key;
+                pattern = fields[i].substr(colon + 1);
+            } else if (!key.empty()) {
+                pattern += "," + fields[i];
+            } else {
+                return false;
+            }
+        }
+        flush();
+        return rule.match_class || rule.match_title || rule.match_workspace;
+    }
+
+public:
+    RuleSet() {
+        reset();
     }
 
-    update_priorities();
-
-    char buffer[1024];
-    std::string pending_data = "";
-    
-    while (true) {
-        ssize_t num_read = read(sfd, buffer, sizeof(buffer) - 1);
-        if (num_read > 0) {
-            buffer[num_read] = '\0';
-            pending_data += buffer;
-            
-            bool dirty = false;
-            size_t pos = 0;
-            while ((pos = pending_data.find('\n')) != std::string::npos) {
-                std::string line = pending_data.substr(0, pos);
-                pending_data.erase(0, pos + 1);
-                
-                if (line.find("workspace") == 0 || line.find("activewindow") == 0) {
-                    dirty = true;
+    void reset() {
+        profiles.clear();
+        profile_index.clear();
+        rules.clear();
+
+        SchedProfile foreground;
+        SchedProfile background;
+        background.nice = 19;
+        define_profile("foreground", foreground);
+        define_profile("background", background);
+    }
+
+    // Returns false if the file cannot be read; the built-in defaults stay.
+    bool load(const std::string& path) {
+        reset();
+        std::ifstream file(path);
+        if (!file.is_open()) return false;
+
+        std::string line;
+        int line_number = 0;
+        while (std::getline(file, line)) {
+            line_number++;
+            line = trim(line.substr(0, line.find('#')));
+            if (line.empty()) continue;
+
+            size_t eq = line.find('=');
+            if (eq == std::string::npos) continue;
+            std::string key = trim(line.substr(0, eq));
+            std::string value = trim(line.substr(eq + 1));
+
+            bool ok = false;
+            try {
+                if (key == "profile") {
+                    size_t comma = value.find(',');
+                    SchedProfile profile;
+                    if (comma != std::string::npos && parse_profile(trim(value.substr(comma + 1)), profile)) {
+                        define_profile(trim(value.substr(0, comma)), profile);
+                        ok = true;
+                    }
+                } else if (key == "rule") {
+                    Rule rule;
+                    if (parse_rule(value, rule)) {
+                        rules.push_back(std::move(rule));
+                        ok = true;
+                    }
                 }
+            } catch (const std::regex_error&) {}
+
+            if (!ok) std::cerr << "hypr-nice: " << path << ":" << line_number << ": ignoring invalid line\n";
+        }
+        return true;
+    }
+
+    int match(const std::string& window_class, const std::string& title, int ws_id) const {
+        for (size_t i = 0; i < rules.size(); ++i) {
+            const Rule& rule = rules[i];
+            if (rule.match_class && !std::regex_search(window_class, rule.class_re)) continue;
+            if (rule.match_title && !std::regex_search(title, rule.title_re)) continue;
+            if (rule.match_workspace && !std::regex_search(std::to_string(ws_id), rule.workspace_re)) continue;
+            return i;
+        }
+        return -1;
+    }
+
+    // rule == -1 selects the built-in foreground/background profiles.
+    const SchedProfile& profile_for(int rule, bool foreground) const {
+        if (rule < 0) return profiles[foreground ? 0 : 1];
+        return profiles[foreground ? rules[rule].foreground_profile : rules[rule].background_profile];
+    }
+};
+
+RuleSet rule_set;
+
+// Remembers which profile each managed client tree currently has, so only
+// changes reach the kernel and new children can be given the same profile.
+class ProfileCache {
+private:
+    std::unordered_map<int, SchedProfile> applied;
+
+public:
+    void apply(int root, const SchedProfile& profile) {
+        auto it = applied.find(root);
+        const SchedProfile& previous = (it != applied.end()) ? it->second : NEUTRAL_PROFILE;
+        if (previous == profile) return;
+
+        for (int member : process_tracker.members_of(root)) apply_profile_to_process(member, profile, previous);
+        applied[root] = profile;
+    }
+
+    bool has(int root) const { return applied.count(root) > 0; }
+
+    // root was split off from's tree and still has from's profile.
+    void split_from(int root, int from) {
+        auto it = applied.find(from);
+        if (it != applied.end() && !applied.count(root)) applied[root] = it->second;
+    }
+
+    void adopt(int root, int pid) {
+        auto it = applied.find(root);
+        if (it != applied.end()) apply_profile_to_process(pid, it->second, NEUTRAL_PROFILE);
+    }
+
+    void forget(int root) {
+        applied.erase(root);
+    }
+
+    // Puts every tree back to the neutral profile, which also ends the
+    // performance lane's pinning.
+    void restore_all() {
+        for (const auto& entry : applied) {
+            for (int member : process_tracker.members_of(entry.first)) apply_profile_to_process(member, NEUTRAL_PROFILE, entry.second);
+        }
+        applied.clear();
+    }
+};
+
+// While a fullscreen window has focus, its client's process tree gets a
+// dedicated set of cores and every other managed client is confined to the
+// remaining ones. Affinity goes back to the profile's own value afterwards.
+class PerformanceLane {
+private:
+    bool enabled = false;
+    cpu_set_t lane_cpus;
+    cpu_set_t other_cpus;
+    int lane_pid = 0;
+
+public:
+    bool configure(const std::string& cpu_list) {
+        if (!parse_cpu_list(cpu_list, lane_cpus)) return false;
+        CPU_AND(&lane_cpus, &lane_cpus, &default_cpus);
+        CPU_XOR(&other_cpus, &default_cpus, &lane_cpus);
+        enabled = CPU_COUNT(&lane_cpus) > 0 && CPU_COUNT(&other_cpus) > 0;
+        return enabled;
+    }
+
+    bool is_enabled() const { return enabled; }
+    bool active() const { return enabled && lane_pid > 0; }
+
+    // Returns true if the lane owner changed and every client needs re-applying.
+    bool set_owner(int pid) {
+        if (!enabled || pid == lane_pid) return false;
+        lane_pid = pid;
+        return true;
+    }
+
+    void adjust(int pid, SchedProfile& profile) const {
+        if (!active()) return;
+        if (pid == lane_pid) {
+            profile.cpus = lane_cpus;
+        } else {
+            cpu_set_t base = profile.pinned ? profile.cpus : default_cpus;
+            CPU_AND(&profile.cpus, &base, &other_cpus);
+            if (CPU_COUNT(&profile.cpus) == 0) profile.cpus = other_cpus;
+        }
+        profile.pinned = true;
+    }
+};
+
+PerformanceLane performance_lane;
+
+const int SHARED_WORKSPACE = -1000;
+
+// Decides how a client pid is prioritized. A pid is foreground when it has a
+// window on a visible workspace (or when hidden workspaces are not being
+// throttled). Its home workspace is the one holding all of its windows, or
+// SHARED_WORKSPACE when they are spread out.
+class PriorityBackend {
+public:
+    virtual ~PriorityBackend() = default;
+    virtual bool init() { return true; }
+    // rule is the index of the first rule matching one of the pid's windows, or -1.
+    virtual void apply(int pid, bool foreground, int home_workspace, int rule) = 0;
+    // A process joined (or exec'd inside) the tree of managed client root.
+    virtual void adopt(int root, int pid) { (void)root; (void)pid; }
+    // Client root was started inside the tree of client from and now has a
+    // tree of its own.
+    virtual void split_from(int root, int from) { (void)root; (void)from; }
+    virtual void forget(int pid) = 0;
+    virtual void workspace_visibility_changed(int ws_id, bool foreground) { (void)ws_id; (void)foreground; }
+    // Undoes what was applied, before hypr-nice exits.
+    virtual void restore() = 0;
+};
+
+// Applies the matching rule's profile, or the built-in nice 0/19 split, to
+// every task of the client's process tree.
+class NiceBackend : public PriorityBackend {
+private:
+    ProfileCache profile_cache;
+
+public:
+    void apply(int pid, bool foreground, int home_workspace, int rule) override {
+        (void)home_workspace;
+        SchedProfile profile = rule_set.profile_for(rule, foreground);
+        performance_lane.adjust(pid, profile);
+        profile_cache.apply(pid, profile);
+    }
+
+    void adopt(int root, int pid) override {
+        profile_cache.adopt(root, pid);
+    }
+
+    void split_from(int root, int from) override {
+        profile_cache.split_from(root, from);
+    }
+
+    void forget(int pid) override {
+        profile_cache.forget(pid);
+    }
+
+    void restore() override {
+        profile_cache.restore_all();
+    }
+};
+
+// Places every client process tree into a child cgroup of a delegated cgroup
+// v2 root, one per workspace ("ws<id>") plus "shared" for pids with windows on
+// several workspaces. Switching workspaces only rewrites cpu.weight/io.weight
+// of the groups involved; processes are migrated only when their home
+// workspace changes, and children forked later inherit the group by default.
+class CgroupBackend : public PriorityBackend {
+private:
+    std::string root;
+    int foreground_weight;
+    int background_weight;
+    std::unordered_set<int> created_groups;
+    std::unordered_map<int, int> pid_group;
+    ProfileCache profile_cache;
+
+    std::string group_path(int ws_id) const {
+        if (ws_id == SHARED_WORKSPACE) return root + "/shared";
+        return root + "/ws" + std::to_string(ws_id);
+    }
+
+    void set_weight(int ws_id, int weight) {
+        std::string path = group_path(ws_id);
+        write_file(path + "/cpu.weight", std::to_string(weight));
+        write_file(path + "/io.weight", "default " + std::to_string(weight));
+    }
+
+    // Weight changes only reach groups that have clients, so a group that
+    // emptied out gets its weight rewritten when a client moves back in.
+    bool ensure_group(int ws_id, bool foreground) {
+        if (!created_groups.count(ws_id)) {
+            std::string path = group_path(ws_id);
+            if (mkdir(path.c_str(), 0755) == -1 && errno != EEXIST) {
+                std::cerr << "hypr-nice: cannot create cgroup " << path << ": " << strerror(errno) << "\n";
+                return false;
+            }
+            created_groups.insert(ws_id);
+        }
+        set_weight(ws_id, foreground ? foreground_weight : background_weight);
+        return true;
+    }
+
+public:
+    CgroupBackend(std::string root_path, int fg_weight, int bg_weight)
+        : root(std::move(root_path)), foreground_weight(fg_weight), background_weight(bg_weight) {}
+
+    bool init() override {
+        if (mkdir(root.c_str(), 0755) == -1 && errno != EEXIST) {
+            std::cerr << "hypr-nice: cannot create cgroup root " << root << ": " << strerror(errno) << "\n";
+            return false;
+        }
+        if (access((root + "/cgroup.procs").c_str(), W_OK) != 0) {
+            std::cerr << "hypr-nice: " << root << " is not a writable cgroup v2 directory\n";
+            return false;
+        }
+
+        // The parent has to hand the controllers down before the root can.
+        // Either may already be enabled or unavailable (e.g. no io controller).
+        std::string parent = root.substr(0, root.find_last_of('/'));
+        for (const char* controller : {"+cpu", "+io"}) {
+            write_file(parent + "/cgroup.subtree_control", controller);
+            write_file(root + "/cgroup.subtree_control", controller);
+        }
+        return true;
+    }
+
+    void apply(int pid, bool foreground, int home_workspace, int rule) override {
+        // Weights do the foreground/background split here; rule profiles and
+        // the performance lane are applied on top, and a tree leaving both
+        // gets the neutral "foreground" profile back.
+        if (rule >= 0 || performance_lane.active() || profile_cache.has(pid)) {
+            SchedProfile profile = rule_set.profile_for(rule, rule < 0 || foreground);
+            performance_lane.adjust(pid, profile);
+            profile_cache.apply(pid, profile);
+        }
+
+        auto placed = pid_group.find(pid);
+        if (placed != pid_group.end() && placed->second == home_workspace) return;
+        if (!ensure_group(home_workspace, foreground || home_workspace == SHARED_WORKSPACE)) return;
+
+        std::string procs = group_path(home_workspace) + "/cgroup.procs";
+        for (int member : process_tracker.members_of(pid)) write_file(procs, std::to_string(member));
+        pid_group[pid] = home_workspace;
+    }
+
+    void adopt(int root, int pid) override {
+        profile_cache.adopt(root, pid);
+    }
+
+    void split_from(int root, int from) override {
+        profile_cache.split_from(root, from);
+    }
+
+    void forget(int pid) override {
+        pid_group.erase(pid);
+        profile_cache.forget(pid);
+    }
+
+    void workspace_visibility_changed(int ws_id, bool foreground) override {
+        if (created_groups.count(ws_id)) set_weight(ws_id, foreground ? foreground_weight : background_weight);
+    }
+
+    // Clients stay in their groups, which all get the foreground weight.
+    void restore() override {
+        profile_cache.restore_all();
+        for (int ws_id : created_groups) set_weight(ws_id, foreground_weight);
+    }
+};
+
+std::unique_ptr<PriorityBackend> priority_backend;
+
+struct Client {
+    int pid;
+    int workspace_id;
+    std::string window_class;
+    std::string title;
+    int rule;
+};
+
+// In-memory mirror of Hyprland's window -> (pid, workspace) table. It is
+// seeded once from j/clients and then kept current from socket2 events, so a
+// workspace switch only touches the windows on the workspaces involved.
+class ClientTable {
+private:
+    std::unordered_map<uint64_t, Client> clients;
+    std::unordered_map<int, std::unordered_set<uint64_t>> workspace_clients;
+    std::unordered_map<int, std::unordered_map<int, int>> pid_workspaces;
+    std::unordered_map<int, std::unordered_set<uint64_t>> pid_windows;
+    std::unordered_set<int> visible_workspaces;
+    std::unordered_set<uint64_t> unresolved_windows;
+    std::unordered_set<int> dirty_pids;
+    bool throttle_hidden = true;
+
+    bool is_visible(int ws_id) const {
+        return visible_workspaces.count(ws_id) > 0;
+    }
+
+    // Hidden workspaces are only deprioritized while throttling is on.
+    bool is_foreground(int ws_id) const {
+        return !throttle_hidden || is_visible(ws_id);
+    }
+
+    void attach(uint64_t addr, int pid, int ws_id) {
+        workspace_clients[ws_id].insert(addr);
+        pid_workspaces[pid][ws_id]++;
+        dirty_pids.insert(pid);
+    }
+
+    void detach(uint64_t addr, int pid, int ws_id) {
+        auto ws_it = workspace_clients.find(ws_id);
+        if (ws_it != workspace_clients.end()) {
+            ws_it->second.erase(addr);
+            if (ws_it->second.empty()) workspace_clients.erase(ws_it);
+        }
+
+        auto& counts = pid_workspaces[pid];
+        if (--counts[ws_id] <= 0) counts.erase(ws_id);
+        dirty_pids.insert(pid);
+    }
+
+    void update_rule(Client& client) {
+        int rule = rule_set.match(client.window_class, client.title, client.workspace_id);
+        if (rule == client.rule) return;
+        client.rule = rule;
+        dirty_pids.insert(client.pid);
+    }
+
+    void add_client(uint64_t addr, int pid, int ws_id, const std::string& window_class, const std::string& title) {
+        Client& client = clients[addr];
+        client = {pid, ws_id, window_class, title, -1};
+        update_rule(client);
+        pid_windows[pid].insert(addr);
+        attach(addr, pid, ws_id);
+    }
+
+    void load_clients(const std::string& clients_out, bool only_unresolved) {
+        JsonReader reader(clients_out);
+        if (!reader.enter_array()) return;
+        while (reader.next_element()) {
+            if (!reader.enter_object()) continue;
+
+            std::string_view address, window_class, title, key;
+            int pid = -999, ws_id = -999;
+            while (reader.next_member(key)) {
+                if (key == "address") reader.read_string(address);
+                else if (key == "pid") reader.read_int(pid);
+                else if (key == "workspace") reader.read_member_int("id", ws_id);
+                else if (key == "class") reader.read_string(window_class);
+                else if (key == "title") reader.read_string(title);
+                else reader.skip();
+            }
+
+            uint64_t addr = parse_address(address);
+            if (clients.count(addr) > 0) continue;
+            if (only_unresolved && unresolved_windows.count(addr) == 0) continue;
+            if (pid > 0 && ws_id != -999) {
+                add_client(addr, pid, ws_id, JsonReader::unescape(window_class), JsonReader::unescape(title));
+            }
+        }
+    }
+
+public:
+    void open_window(uint64_t addr) {
+        if (clients.count(addr) == 0) unresolved_windows.insert(addr);
+    }
+
+    void close_window(uint64_t addr) {
+        unresolved_windows.erase(addr);
+
+        auto it = clients.find(addr);
+        if (it == clients.end()) return;
+
+        Client client = it->second;
+        clients.erase(it);
+        pid_windows[client.pid].erase(addr);
+        detach(addr, client.pid, client.workspace_id);
+    }
+
+    void move_window(uint64_t addr, int ws_id) {
+        auto it = clients.find(addr);
+        if (it == clients.end()) {
+            open_window(addr);
+            return;
+        }
+
+        Client& client = it->second;
+        if (client.workspace_id == ws_id) return;
+
+        detach(addr, client.pid, client.workspace_id);
+        client.workspace_id = ws_id;
+        attach(addr, client.pid, ws_id);
+        update_rule(client);
+    }
+
+    void retitle_window(uint64_t addr, const std::string& title) {
+        auto it = clients.find(addr);
+        if (it == clients.end()) return;
+        it->second.title = title;
+        update_rule(it->second);
+    }
+
+    int pid_of(uint64_t addr) const {
+        auto it = clients.find(addr);
+        return (it != clients.end()) ? it->second.pid : 0;
+    }
+
+    void mark_all_dirty() {
+        for (const auto& entry : pid_windows) dirty_pids.insert(entry.first);
+    }
+
+    // Re-matches every window after the rule file changed. Profiles may have
+    // changed under an unchanged rule index, so every pid is re-applied.
+    void reload_rules() {
+        for (auto& entry : clients) {
+            update_rule(entry.second);
+            dirty_pids.insert(entry.second.pid);
+        }
+    }
+
+    void set_workspace_visible(int ws_id, bool visible) {
+        if (is_visible(ws_id) == visible) return;
+        if (visible) visible_workspaces.insert(ws_id);
+        else visible_workspaces.erase(ws_id);
+        if (throttle_hidden) priority_backend->workspace_visibility_changed(ws_id, visible);
+
+        auto ws_it = workspace_clients.find(ws_id);
+        if (ws_it == workspace_clients.end()) return;
+        for (uint64_t addr : ws_it->second) dirty_pids.insert(clients[addr].pid);
+    }
+
+    void set_visible_workspaces(const std::unordered_set<int>& visible) {
+        std::vector<int> previous(visible_workspaces.begin(), visible_workspaces.end());
+        for (int old_id : previous) {
+            if (visible.count(old_id) == 0) set_workspace_visible(old_id, false);
+        }
+        for (int ws_id : visible) set_workspace_visible(ws_id, true);
+    }
+
+    bool throttling() const { return throttle_hidden; }
+
+    void set_throttling(bool enabled) {
+        if (throttle_hidden == enabled) return;
+        throttle_hidden = enabled;
+
+        for (const auto& entry : workspace_clients) {
+            if (is_visible(entry.first)) continue;
+            priority_backend->workspace_visibility_changed(entry.first, !enabled);
+            for (uint64_t addr : entry.second) dirty_pids.insert(clients[addr].pid);
+        }
+    }
+
+    // Fills in pid and workspace for every window opened since the last call.
+    // The whole client list is fetched at most once per batch of new windows.
+    void resolve_new_windows() {
+        if (unresolved_windows.empty()) return;
+        load_clients(ipc.query_json("clients"), true);
+        unresolved_windows.clear();
+    }
+
+    void apply_priorities() {
+        for (int pid : dirty_pids) {
+            auto it = pid_workspaces.find(pid);
+            if (it == pid_workspaces.end()) continue;
+
+            const auto& counts = it->second;
+            if (counts.empty()) {
+                priority_backend->forget(pid);
+                process_tracker.unmanage(pid);
+                pid_workspaces.erase(it);
+                pid_windows.erase(pid);
+                continue;
             }
-            if (dirty) update_priorities();
+            int launcher = process_tracker.manage(pid);
+            if (launcher) priority_backend->split_from(pid, launcher);
+
+            bool foreground = false;
+            for (const auto& entry : counts) {
+                if (is_foreground(entry.first)) foreground = true;
+            }
+            int rule = -1;
+            for (uint64_t addr : pid_windows[pid]) {
+                int window_rule = clients[addr].rule;
+                if (window_rule >= 0 && (rule < 0 || window_rule < rule)) rule = window_rule;
+            }
+            int home_workspace = (counts.size() == 1) ? counts.begin()->first : SHARED_WORKSPACE;
+            priority_backend->apply(pid, foreground, home_workspace, rule);
+        }
+        dirty_pids.clear();
+    }
+
+    void seed() {
+        load_clients(ipc.query_json("clients"), false);
+    }
+};
+
+ClientTable client_table;
+
+struct MonitorState {
+    int active_workspace = -999;
+    int special_workspace = 0;
+};
+
+// Tracks the workspace shown on every monitor plus any open special
+// workspace. Together they form the visible set; everything else is hidden.
+class MonitorTracker {
+private:
+    std::unordered_map<std::string, MonitorState> monitors;
+    std::string focused_monitor;
+
+    void publish() {
+        std::unordered_set<int> visible;
+        for (const auto& entry : monitors) {
+            if (entry.second.active_workspace != -999) visible.insert(entry.second.active_workspace);
+            if (entry.second.special_workspace != 0) visible.insert(entry.second.special_workspace);
+        }
+        client_table.set_visible_workspaces(visible);
+    }
+
+public:
+    bool sync() {
+        std::vector<HyprlandSnapshot::Monitor> list;
+        monitors.clear();
+        if (!ipc.monitors(list)) return false;
+        for (const auto& monitor : list) {
+            monitors[monitor.name] = MonitorState{monitor.active_workspace, monitor.special_workspace};
+            if (monitor.focused) focused_monitor = monitor.name;
+        }
+        if (monitors.empty()) return false;
+
+        publish();
+        return true;
+    }
+
+    void workspace_changed(int ws_id) {
+        auto it = monitors.find(focused_monitor);
+        if (it == monitors.end()) {
+            sync();
+            return;
+        }
+        it->second.active_workspace = ws_id;
+        publish();
+    }
+
+    void focus_changed(const std::string& monitor, int ws_id) {
+        focused_monitor = monitor;
+        monitors[monitor].active_workspace = ws_id;
+        publish();
+    }
+
+    void special_changed(int ws_id, const std::string& monitor) {
+        monitors[monitor].special_workspace = ws_id;
+        publish();
+    }
+
+    void monitor_removed(const std::string& monitor) {
+        monitors.erase(monitor);
+        publish();
+    }
+};
+
+MonitorTracker monitor_tracker;
+
+uint64_t focused_window = 0;
+uint64_t fullscreen_window = 0;
+
+// The lane belongs to the fullscreen window's client for as long as that
+// window keeps focus; its pid may only be known after resolve_new_windows().
+void update_performance_lane() {
+    if (!performance_lane.is_enabled()) return;
+    int owner = (fullscreen_window != 0 && fullscreen_window == focused_window) ? client_table.pid_of(fullscreen_window) : 0;
+    if (performance_lane.set_owner(owner)) client_table.mark_all_dirty();
+}
+
+void register_event_handlers(EventDispatcher& dispatcher) {
+    dispatcher.on<OpenWindowEvent>([](const OpenWindowEvent& event) {
+        client_table.open_window(parse_address(event.address));
+    });
+    dispatcher.on<CloseWindowEvent>([](const CloseWindowEvent& event) {
+        uint64_t addr = parse_address(event.address);
+        if (addr == fullscreen_window) fullscreen_window = 0;
+        client_table.close_window(addr);
+    });
+    dispatcher.on<ActiveWindowV2Event>([](const ActiveWindowV2Event& event) {
+        focused_window = parse_address(event.address);
+    });
+    dispatcher.on<FullscreenEvent>([](const FullscreenEvent& event) {
+        fullscreen_window = event.enabled ? focused_window : 0;
+    });
+    dispatcher.on<MoveWindowV2Event>([](const MoveWindowV2Event& event) {
+        client_table.move_window(parse_address(event.address), event.workspace_id);
+    });
+    dispatcher.on<WindowTitleV2Event>([](const WindowTitleV2Event& event) {
+        client_table.retitle_window(parse_address(event.address), std::string(event.title));
+    });
+    dispatcher.on<WorkspaceV2Event>([](const WorkspaceV2Event& event) {
+        monitor_tracker.workspace_changed(event.workspace_id);
+    });
+    dispatcher.on<FocusedMonV2Event>([](const FocusedMonV2Event& event) {
+        monitor_tracker.focus_changed(std::string(event.monitor), event.workspace_id);
+    });
+    dispatcher.on<ActiveSpecialV2Event>([](const ActiveSpecialV2Event& event) {
+        monitor_tracker.special_changed(event.workspace_id, std::string(event.monitor));
+    });
+    dispatcher.on<MonitorRemovedEvent>([](const MonitorRemovedEvent& event) {
+        monitor_tracker.monitor_removed(std::string(event.monitor));
+    });
+    auto resync_monitors = [](std::string_view) { monitor_tracker.sync(); };
+    dispatcher.on(HyprEvent::MonitorAdded, resync_monitors);
+    dispatcher.on(HyprEvent::MoveWorkspaceV2, resync_monitors);
+}
+
+// Registers PSI triggers so hidden workspaces are only throttled while the
+// system is actually contended. A trigger fires when "some" stall time in a
+// 2 s window exceeds the threshold; throttling is lifted again once avg10
+// of every watched resource has dropped back below its threshold.
+class PressureMonitor {
+private:
+    struct Resource {
+        std::string name;
+        int threshold_pct;
+        int fd = -1;
+    };
+    std::vector<Resource> resources;
+
+    // Unprivileged triggers need a window that is a multiple of 2 s.
+    static const int WINDOW_US = 2000000;
+
+    static double read_avg10(const std::string& name) {
+        std::ifstream pressure_file("/proc/pressure/" + name);
+        std::string line;
+        while (std::getline(pressure_file, line)) {
+            if (line.rfind("some ", 0) != 0) continue;
+            size_t pos = line.find("avg10=");
+            if (pos != std::string::npos) return atof(line.c_str() + pos + 6);
+        }
+        return 0.0;
+    }
+
+public:
+    ~PressureMonitor() {
+        for (auto& resource : resources) {
+            if (resource.fd != -1) close(resource.fd);
+        }
+    }
+
+    void add(const std::string& name, int threshold_pct) {
+        resources.push_back({name, std::clamp(threshold_pct, 1, 100)});
+    }
+
+    bool empty() const { return resources.empty(); }
+
+    bool open_triggers() {
+        for (auto& resource : resources) {
+            std::string path = "/proc/pressure/" + resource.name;
+            resource.fd = open(path.c_str(), O_RDWR | O_NONBLOCK | O_CLOEXEC);
+            if (resource.fd == -1) {
+                std::cerr << "hypr-nice: cannot open " << path << ": " << strerror(errno) << "\n";
+                return false;
+            }
+
+            long stall_us = (long)WINDOW_US * resource.threshold_pct / 100;
+            std::string trigger = "some " + std::to_string(stall_us) + " " + std::to_string(WINDOW_US);
+            if (write(resource.fd, trigger.c_str(), trigger.length() + 1) == -1) {
+                std::cerr << "hypr-nice: cannot register PSI trigger on " << path << ": " << strerror(errno) << "\n";
+                return false;
+            }
+        }
+        return true;
+    }
+
+    std::vector<int> fds() const {
+        std::vector<int> out;
+        for (const auto& resource : resources) out.push_back(resource.fd);
+        return out;
+    }
+
+    bool above_threshold() const {
+        for (const auto& resource : resources) {
+            if (read_avg10(resource.name) >= resource.threshold_pct) return true;
+        }
+        return false;
+    }
+
+    static int recheck_interval_ms() { return WINDOW_US / 1000; }
+};
+
+PressureMonitor pressure_monitor;
+
+void print_usage() {
+    std::cerr << "Usage: hypr-nice [--cgroup [ROOT]] [--fg-weight N] [--bg-weight N] [--scan-interval MS]\n"
+              << "                 [--psi PCT] [--psi-io PCT] [--psi-memory PCT] [--rules FILE]\n"
+              << "                 [--lane-cpus LIST]\n"
+              << "  --cgroup [ROOT]  place clients in per-workspace cgroup v2 groups under ROOT\n"
+              << "                   (default: a \"hypr-nice\" sibling of the daemon's own cgroup)\n"
+              << "  --fg-weight N    cpu.weight/io.weight of visible workspaces (default 1000)\n"
+              << "  --bg-weight N    cpu.weight/io.weight of hidden workspaces (default 10)\n"
+              << "  --scan-interval MS  /proc rescan period when the proc connector is\n"
+              << "                   unavailable (default 2000)\n"
+              << "  --psi PCT        only throttle hidden workspaces while CPU pressure\n"
+              << "                   (some, 2 s window) exceeds PCT percent\n"
+              << "  --psi-io PCT     same for I/O pressure\n"
+              << "  --psi-memory PCT same for memory pressure\n"
+              << "  --rules FILE     window rule file, reloaded when it changes\n"
+              << "                   (default: $XDG_CONFIG_HOME/hypr/user/configs/hypr-nice.conf)\n"
+              << "  --lane-cpus LIST reserve these cores (e.g. 2-7) for a focused fullscreen\n"
+              << "                   window and keep every other client off them\n";
+}
+
+std::string default_rules_path() {
+    const char* xdg_env = std::getenv("XDG_CONFIG_HOME");
+    if (xdg_env && *xdg_env != '\0') return std::string(xdg_env) + "/hypr/user/configs/hypr-nice.conf";
+
+    const char* home_env = std::getenv("HOME");
+    if (!home_env) return "";
+    return std::string(home_env) + "/.config/hypr/user/configs/hypr-nice.conf";
+}
+
+// Resolves the default cgroup root from the unified hierarchy entry in
+// /proc/self/cgroup, assuming cgroup2 is mounted at /sys/fs/cgroup.
+std::string default_cgroup_root() {
+    std::ifstream cgroup_file("/proc/self/cgroup");
+    std::string line;
+    while (std::getline(cgroup_file, line)) {
+        if (line.rfind("0::", 0) != 0) continue;
+        std::string own = line.substr(3);
+        std::string parent = own.substr(0, own.find_last_of('/'));
+        return "/sys/fs/cgroup" + parent + "/hypr-nice";
+    }
+    return "";
+}
+
+int main(int argc, char** argv) {
+    bool use_cgroup = false;
+    std::string cgroup_root;
+    int fg_weight = 1000;
+    int bg_weight = 10;
+    int scan_interval_ms = 2000;
+    std::string rules_path = default_rules_path();
+    std::string lane_cpus;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc && argv[i + 1][0] != '-';
+        if (arg == "--cgroup") {
+            use_cgroup = true;
+            if (has_value) cgroup_root = argv[++i];
+        } else if (arg == "--fg-weight" && has_value) {
+            fg_weight = std::clamp(atoi(argv[++i]), 1, 10000);
+        } else if (arg == "--bg-weight" && has_value) {
+            bg_weight = std::clamp(atoi(argv[++i]), 1, 10000);
+        } else if (arg == "--scan-interval" && has_value) {
+            scan_interval_ms = std::max(atoi(argv[++i]), 100);
+        } else if (arg == "--psi" && has_value) {
+            pressure_monitor.add("cpu", atoi(argv[++i]));
+        } else if (arg == "--psi-io" && has_value) {
+            pressure_monitor.add("io", atoi(argv[++i]));
+        } else if (arg == "--psi-memory" && has_value) {
+            pressure_monitor.add("memory", atoi(argv[++i]));
+        } else if (arg == "--rules" && has_value) {
+            rules_path = argv[++i];
+        } else if (arg == "--lane-cpus" && has_value) {
+            lane_cpus = argv[++i];
         } else {
-            break;
+            print_usage();
+            return 1;
+        }
+    }
+
+    if (use_cgroup) {
+        if (cgroup_root.empty()) cgroup_root = default_cgroup_root();
+        priority_backend = std::make_unique<CgroupBackend>(cgroup_root, fg_weight, bg_weight);
+    } else {
+        priority_backend = std::make_unique<NiceBackend>();
+    }
+    if (!priority_backend->init()) return 1;
+
+    if (!ipc.available()) return 1;
+
+    sched_getaffinity(0, sizeof(cpu_set_t), &default_cpus);
+    rule_set.load(rules_path);
+    if (!lane_cpus.empty() && !performance_lane.configure(lane_cpus)) {
+        std::cerr << "hypr-nice: --lane-cpus must name some, but not all, of the usable cores\n";
+        return 1;
+    }
+
+    EventLoop loop;
+    // A lane or throttling left in place would outlive the daemon, so both
+    // are undone once the loop stops.
+    loop.add_signal(SIGTERM, [&loop]() { loop.stop(); });
+    loop.add_signal(SIGINT, [&loop]() { loop.stop(); });
+
+    FileWatch rules_watch(loop);
+    rules_watch.watch(rules_path, [rules_path]() {
+        rule_set.load(rules_path);
+        client_table.reload_rules();
+        client_table.apply_priorities();
+    });
+
+    process_tracker.on_new_member = [](int root, int pid) {
+        priority_backend->adopt(root, pid);
+    };
+    if (process_tracker.open_connector()) {
+        loop.add_fd(process_tracker.fd(), EPOLLIN, [](uint32_t) {
+            if (!process_tracker.handle_connector_events()) process_tracker.rescan();
+        });
+    } else {
+        loop.add_timer(scan_interval_ms, true, []() {
+            process_tracker.rescan();
+        });
+    }
+
+    int recheck_timer = -1;
+    if (!pressure_monitor.empty()) {
+        if (!pressure_monitor.open_triggers()) return 1;
+
+        recheck_timer = loop.add_timer(0, false, [&loop, &recheck_timer]() {
+            if (pressure_monitor.above_threshold()) return;
+            client_table.set_throttling(false);
+            client_table.apply_priorities();
+            loop.set_timer(recheck_timer, 0, false);
+        });
+        auto start_throttling = [&loop, &recheck_timer]() {
+            if (client_table.throttling()) return;
+            client_table.set_throttling(true);
+            client_table.apply_priorities();
+            loop.set_timer(recheck_timer, PressureMonitor::recheck_interval_ms(), true);
+        };
+
+        for (int fd : pressure_monitor.fds()) {
+            loop.add_fd(fd, EPOLLPRI, [&loop, fd, start_throttling](uint32_t events) {
+                if (events & EPOLLERR) {
+                    loop.remove_fd(fd);
+                    return;
+                }
+                start_throttling();
+            });
         }
+
+        client_table.set_throttling(false);
+        if (pressure_monitor.above_threshold()) start_throttling();
     }
 
+    int sfd = ipc.connect_events(SOCK_NONBLOCK);
+    if (sfd == -1) return 1;
+
+    if (!monitor_tracker.sync()) {
+        close(sfd);
+        return 1;
+    }
+    client_table.seed();
+    if (performance_lane.is_enabled()) {
+        std::string active_out = ipc.query_json("activewindow");
+        JsonReader reader(active_out);
+        std::string_view key, address;
+        int fullscreen = 0;
+        if (reader.enter_object()) {
+            while (reader.next_member(key)) {
+                if (key == "address") reader.read_string(address);
+                else if (key == "fullscreen") reader.read_int(fullscreen);
+                else reader.skip();
+            }
+        }
+        focused_window = parse_address(address);
+        if (fullscreen > 0) fullscreen_window = focused_window;
+        update_performance_lane();
+    }
+    client_table.apply_priorities();
+
+    LineReader events;
+    EventDispatcher dispatcher;
+    register_event_handlers(dispatcher);
+
+    auto on_batch = []() {
+        client_table.resolve_new_windows();
+        update_performance_lane();
+        client_table.apply_priorities();
+    };
+    add_event_socket(loop, sfd, events, dispatcher, on_batch, [&loop]() { loop.stop(); });
+
+    loop.run();
+    priority_backend->restore();
+
     close(sfd);
     return 0;
 }
@@ -2,18 +2,29 @@
 #include <fstream> 
 #include <string> 
 #include <vector> 
+#include <array> 
 #include <memory> 
-#include <thread> 
 #include <chrono> 
 #include <cstdlib> 
 #include <algorithm> 
+#include <cmath> 
 #include <unistd.h> 
 #include <sys/wait.h> 
-#include <atomic> 
-#include <sstream> 
-#include <dirent.h>
-#include <nlohmann/json.hpp>
+#include <sys/epoll.h> 
+#include <sys/socket.h> 
+#include <fcntl.h> 
+#include <csignal> 
 #include <optional>
+#include <functional>
+#include "hyprland-ipc.hpp"
+#include "line-reader.hpp"
+#include "hyprland-events.hpp"
+#include "layer-tracker.hpp"
+#include "event-loop.hpp"
+#include "event-socket.hpp"
+#include "process-supervisor.hpp"
+#include "file-watch.hpp"
+#include "edge-trigger.hpp"
 
 void log_error(const std::string& msg) {
     std::ofstream log_file("/tmp/nekoroshell-navbar.log", std::ios_base::app);
@@ -25,152 +36,389 @@ void log_error(const std::string& msg) {
     }
 }
 
-using json = nlohmann::json;
 
-struct Monitor { int x, y, w, h; }; 
+// Layout rectangle in logical pixels, plus the reserved area along each edge
+// (left, top, right, bottom). 
+struct Monitor { 
+    int x, y, w, h; 
+    std::array<int, 4> reserved{}; 
+    std::string name; 
+}; 
 struct Config { 
     int activate_size = 10; 
     int deactivate_size = 40; 
     std::string bar_position = "top"; 
 }; 
 
-struct PipeDeleter { 
-    void operator()(FILE* stream) const { if (stream) pclose(stream); } 
-}; 
-
-std::string exec(const char* cmd) { 
-    char buffer[4096]; 
-    std::string result = ""; 
-    std::unique_ptr<FILE, PipeDeleter> pipe(popen(cmd, "r")); 
-    if (!pipe) {
-        log_error("popen() failed to execute command: " + std::string(cmd));
-        return "";
-    }
-    while (fgets(buffer, sizeof(buffer), pipe.get()) != nullptr) { 
-        result += buffer; 
-    } 
-    return result; 
-} 
-
-pid_t get_waybar_pid() { 
-    DIR* dir = opendir("/proc");
-    if (!dir) return -1;
-    struct dirent* ent;
-    while ((ent = readdir(dir)) != nullptr) {
-        if (!isdigit(ent->d_name[0])) continue;
-        std::string pid_str = ent->d_name;
-        std::ifstream comm_file("/proc/" + pid_str + "/comm");
-        if (comm_file.is_open()) {
-            std::string comm_name;
-            std::getline(comm_file, comm_name);
-            if (comm_name == "waybar") {
-                closedir(dir);
-                return std::stoi(pid_str);
-            }
-        }
-    }
-    closedir(dir);
-    return -1;
-} 
-
 class CompositorBackend { 
 public: 
     virtual ~CompositorBackend() = default; 
     virtual std::vector<Monitor> get_monitors() = 0; 
+    // Runs on_change whenever outputs are added, removed or reconfigured. 
+    virtual void watch_monitors(std::function<void()> on_change) = 0; 
     virtual bool get_cursor_pos(int& x, int& y) = 0; 
+    // Answered from memory; only meaningful once watch_layers() succeeded. 
     virtual bool is_layer_active(const std::string& layer_name) = 0; 
+    // Whether Waybar's own layer is among those is_layer_active() knows. 
+    virtual bool sees_bar_layer() const = 0; 
+    // Seeds the layer state and keeps it current from loop. on_change runs
+    // with the namespace of every layer that opens or closes. 
+    virtual bool watch_layers(EventLoop& loop, LayerTracker::ChangeCallback on_change) = 0; 
 }; 
 
 class HyprlandBackend : public CompositorBackend { 
+private: 
+    HyprlandIPC ipc; 
+    int event_fd = -1; 
+    LineReader events; 
+    EventDispatcher dispatcher; 
+    LayerTracker layers; 
+
 public: 
     std::vector<Monitor> get_monitors() override { 
         std::vector<Monitor> monitors; 
-        std::string mon_out = exec("hyprctl -j monitors"); 
-        if (mon_out.empty() || mon_out.front() != '[') return monitors;
-        try {
-            auto j = json::parse(mon_out);
-            for (const auto& m : j) {
-                monitors.push_back({m["x"], m["y"], m["width"], m["height"]});
-            }
-        } catch (...) {}
+        std::vector<HyprlandSnapshot::Monitor> list; 
+        if (!ipc.monitors(list)) return monitors; 
+        for (const auto& monitor : list) { 
+            Monitor m{monitor.x, monitor.y, monitor.width, monitor.height, monitor.reserved, monitor.name}; 
+            // The mode is in physical pixels, while x, y and cursorpos are
+            // logical. 
+            if (monitor.scale > 0) { 
+                m.w = static_cast<int>(std::lround(m.w / monitor.scale)); 
+                m.h = static_cast<int>(std::lround(m.h / monitor.scale)); 
+            } 
+            if (monitor.transform % 2 == 1) std::swap(m.w, m.h); 
+            monitors.push_back(m); 
+        } 
         return monitors; 
     } 
 
+    // The v2 events follow their v1 twins, so only the v1 ones are handled. 
+    void watch_monitors(std::function<void()> on_change) override { 
+        auto handler = [on_change](std::string_view) { on_change(); }; 
+        dispatcher.on(HyprEvent::MonitorAdded, handler); 
+        dispatcher.on(HyprEvent::MonitorRemoved, handler); 
+        dispatcher.on(HyprEvent::ConfigReloaded, handler); 
+    } 
+
     bool get_cursor_pos(int& x, int& y) override { 
-        std::string pos_out = exec("hyprctl cursorpos"); 
+        std::string pos_out = ipc.request("cursorpos"); 
         return (sscanf(pos_out.c_str(), "%d, %d", &x, &y) == 2); 
     } 
 
     bool is_layer_active(const std::string& layer_name) override { 
-        std::string layers = exec("hyprctl layers"); 
-        return (layers.find(layer_name) != std::string::npos); 
+        return layers.is_active(layer_name); 
+    } 
+
+    bool sees_bar_layer() const override { 
+        return true; 
+    } 
+
+    bool watch_layers(EventLoop& loop, LayerTracker::ChangeCallback on_change) override { 
+        event_fd = ipc.connect_events(SOCK_NONBLOCK); 
+        if (event_fd == -1) return false; 
+
+        // Seed after subscribing so no layer event falls in between. 
+        std::vector<HyprlandSnapshot::Layer> mapped; 
+        if (ipc.layers(mapped)) layers.seed(mapped); 
+        layers.attach(dispatcher, on_change); 
+
+        return add_event_socket(loop, event_fd, events, dispatcher, nullptr, [this, &loop]() { 
+            log_error("Lost the Hyprland event socket."); 
+            close(event_fd); 
+            event_fd = -1; 
+            loop.stop(); 
+        }); 
     } 
 }; 
 
 class SwayBackend : public CompositorBackend { 
+private: 
+    pid_t swaync_pid = -1; 
+    int swaync_fd = -1; 
+    LineReader swaync_events; 
+    LayerTracker layers; 
+
 public: 
+    ~SwayBackend() override { 
+        if (swaync_pid > 0) kill(swaync_pid, SIGTERM); 
+    } 
+
+    // Sway gives no cursor position, so there is nothing to hit-test the
+    // outputs against. 
     std::vector<Monitor> get_monitors() override { 
-        std::vector<Monitor> monitors; 
-        std::string cmd = "swaymsg -t get_outputs -r | jq -r '.[] | \"\\(.rect.x) \\(.rect.y) \\(.rect.width) \\(.rect.height)\"'"; 
-        std::string out = exec(cmd.c_str()); 
-         
-        std::stringstream ss(out); 
-        int x, y, w, h; 
-        while (ss >> x >> y >> w >> h) { 
-            monitors.push_back({x, y, w, h}); 
-        } 
-        return monitors; 
+        return {}; 
     } 
 
+    void watch_monitors(std::function<void()>) override {} 
+
     bool get_cursor_pos(int& x, int& y) override { 
         x = -1; y = -1; 
         return false;  
     } 
 
+    // Sway has no layer events and its IPC does not list layer surfaces, so
+    // only the control center is tracked, through swaync's own subscription. 
     bool is_layer_active(const std::string& layer_name) override { 
-        if (layer_name == "swaync-control-center") { 
-            std::string state = exec("timeout 0.5 swaync-client -s 2>/dev/null"); 
-            return state.find("\"visible\": true") != std::string::npos ||  
-                   state.find("\"visible\":true") != std::string::npos; 
+        return layers.is_active(layer_name); 
+    } 
+
+    bool sees_bar_layer() const override { 
+        return false; 
+    } 
+
+    // Keeps one `swaync-client --subscribe` running; it prints a JSON state
+    // line, including "visible", whenever the control center changes. 
+    bool watch_layers(EventLoop& loop, LayerTracker::ChangeCallback on_change) override { 
+        int fds[2]; 
+        if (pipe2(fds, O_CLOEXEC) == -1) return false; 
+
+        pid_t pid = fork(); 
+        if (pid == -1) { 
+            close(fds[0]); 
+            close(fds[1]); 
+            return false; 
+        } 
+        if (pid == 0) { 
+            loop.unblock_signals(); 
+            dup2(fds[1], STDOUT_FILENO); 
+            char* args[] = {(char*)"swaync-client", (char*)"--subscribe", nullptr}; 
+            execvp(args[0], args); 
+            _exit(1); 
         } 
-        std::string cmd = "lswt -j 2>/dev/null | jq -e '.[] | select(.namespace == \"" + layer_name + "\")' >/dev/null 2>&1"; 
-        return system(cmd.c_str()) == 0; 
+        close(fds[1]); 
+        swaync_fd = fds[0]; 
+        swaync_pid = pid; 
+        loop.watch_child(pid, [this, pid](int) { 
+            if (swaync_pid == pid) swaync_pid = -1; 
+        }); 
+
+        return loop.add_fd(swaync_fd, EPOLLIN, [this, &loop, on_change](uint32_t) { 
+            ssize_t num_read = swaync_events.fill(swaync_fd); 
+            if (num_read == -1 && errno == EINTR) return; 
+            if (num_read <= 0) { 
+                // Without swaync the control center simply counts as closed. 
+                loop.remove_fd(swaync_fd); 
+                close(swaync_fd); 
+                swaync_fd = -1; 
+                return; 
+            } 
+
+            std::string_view line; 
+            bool changed = false; 
+            while (swaync_events.next_line(line)) { 
+                bool visible = line.find("\"visible\": true") != std::string_view::npos || 
+                               line.find("\"visible\":true") != std::string_view::npos; 
+                if (visible != layers.is_active("swaync-control-center")) { 
+                    layers.set("swaync-control-center", visible); 
+                    changed = true; 
+                } 
+            } 
+            if (changed) on_change("swaync-control-center"); 
+        }); 
     } 
 }; 
 
 std::unique_ptr<CompositorBackend> backend; 
-std::atomic<bool> is_swaync_open_flag{false}; 
+EventLoop event_loop; 
+bool is_swaync_open = false; 
 bool is_bar_visible = true; 
-pid_t current_waybar_pid = -1;
+ProcessSupervisor waybar(event_loop, "waybar"); 
+std::unique_ptr<EdgeTrigger> edge_trigger; 
 
-void swaync_watcher_thread() { 
-    while (true) { 
-        if (backend) { 
-            bool is_open = backend->is_layer_active("swaync-control-center"); 
-            is_swaync_open_flag.store(is_open); 
-        } 
-        std::this_thread::sleep_for(std::chrono::milliseconds(200));  
+void set_bar_visible(bool visible) { 
+    is_bar_visible = visible; 
+    if (edge_trigger) edge_trigger->set_bar_visible(visible); 
+} 
+
+// Waybar dies from a SIGUSR1 that arrives before it has installed its
+// handler, so a Waybar we started is not toggled until it has mapped its bar
+// or WAYBAR_READY_TIMEOUT_MS has passed. Where its layer cannot be seen it
+// is given WAYBAR_SETTLE_MS instead. 
+constexpr int WAYBAR_READY_TIMEOUT_MS = 5000; 
+constexpr int WAYBAR_SETTLE_MS = 1000; 
+bool is_waybar_ready = false; 
+int ready_timer = -1; 
+
+// A Waybar that exits is started again after RESPAWN_MIN_DELAY_MS, doubling
+// up to RESPAWN_MAX_DELAY_MS while it keeps exiting. One that stayed up for
+// RESPAWN_STABLE_MS starts over at the minimum. 
+constexpr int RESPAWN_MIN_DELAY_MS = 1000; 
+constexpr int RESPAWN_MAX_DELAY_MS = 30000; 
+constexpr int RESPAWN_STABLE_MS = 60000; 
+int respawn_delay_ms = RESPAWN_MIN_DELAY_MS; 
+int respawn_timer = -1; 
+std::chrono::steady_clock::time_point waybar_started; 
+
+void waybar_exited(int status) { 
+    if (status != -1 && WIFEXITED(status) && WEXITSTATUS(status) == 127) { 
+        log_error("execvp failed to spawn Waybar."); 
     } 
+    is_waybar_ready = false; 
+    event_loop.set_timer(ready_timer, 0, false); 
+    if (std::chrono::steady_clock::now() - waybar_started >= std::chrono::milliseconds(RESPAWN_STABLE_MS)) { 
+        respawn_delay_ms = RESPAWN_MIN_DELAY_MS; 
+    } 
+    log_error("Waybar exited, starting it again in " + std::to_string(respawn_delay_ms) + " ms."); 
+    event_loop.set_timer(respawn_timer, respawn_delay_ms, false); 
+    respawn_delay_ms = std::min(respawn_delay_ms * 2, RESPAWN_MAX_DELAY_MS); 
+} 
+
+// A new Waybar comes up with its bar shown. 
+void start_waybar() { 
+    waybar_started = std::chrono::steady_clock::now(); 
+    is_waybar_ready = false; 
+    set_bar_visible(true); 
+    if (waybar.spawn() <= 0) { 
+        log_error("fork failed to spawn Waybar."); 
+        waybar_exited(-1); 
+        return; 
+    } 
+    event_loop.set_timer(ready_timer, backend->sees_bar_layer() ? WAYBAR_READY_TIMEOUT_MS : WAYBAR_SETTLE_MS, false); 
 } 
 
 void toggle_waybar(bool want_visible) { 
-    if (want_visible != is_bar_visible) { 
-        if (current_waybar_pid > 0 && kill(current_waybar_pid, 0) == 0) {
-            kill(current_waybar_pid, SIGUSR1);
-        } else {
-            pid_t pid = get_waybar_pid();
-            if (pid > 0) {
-                current_waybar_pid = pid;
-                kill(current_waybar_pid, SIGUSR1);
-            }
-        }
-        is_bar_visible = want_visible; 
+    if (want_visible != is_bar_visible && is_waybar_ready) { 
+        waybar.signal(SIGUSR1); 
+        set_bar_visible(want_visible); 
     } 
 } 
 
-std::optional<Config> read_config() { 
-    Config cfg;
+// The bar edge of one monitor, flattened so a cursor sample costs a few
+// integer compares. The cursor is over the region while its coordinate along
+// the edge is in [lo, hi), at depth (across - edge) * sign from the edge. 
+struct EdgeRegion { 
+    bool along_x; 
+    int lo, hi; 
+    int edge, sign; 
+    int activate, deactivate; 
+}; 
+
+std::vector<EdgeRegion> build_edge_regions(const std::vector<Monitor>& monitors, const Config& cfg) { 
+    std::vector<EdgeRegion> regions; 
+    regions.reserve(monitors.size()); 
+    for (const auto& m : monitors) { 
+        EdgeRegion r; 
+        int reserved; 
+        if (cfg.bar_position == "bottom") { 
+            r = {true, m.x, m.x + m.w, m.y + m.h, -1, 0, 0}; 
+            reserved = m.reserved[3]; 
+        } else if (cfg.bar_position == "left") { 
+            r = {false, m.y, m.y + m.h, m.x, 1, 0, 0}; 
+            reserved = m.reserved[0]; 
+        } else if (cfg.bar_position == "right") { 
+            r = {false, m.y, m.y + m.h, m.x + m.w, -1, 0, 0}; 
+            reserved = m.reserved[2]; 
+        } else { 
+            r = {true, m.x, m.x + m.w, m.y, 1, 0, 0}; 
+            reserved = m.reserved[1]; 
+        } 
+        // A shown bar's exclusive zone is part of the reserved area, so the
+        // bar never hides while the pointer is still on it. 
+        r.activate = cfg.activate_size; 
+        r.deactivate = std::max(cfg.deactivate_size, reserved); 
+        regions.push_back(r); 
+    } 
+    return regions; 
+} 
+
+// Depth past the edge at which a shown bar hides. The trigger strip uses one
+// depth on every output, so it takes the widest. 
+int hide_depth(const std::vector<EdgeRegion>& regions, const Config& cfg) { 
+    int depth = cfg.deactivate_size; 
+    for (const auto& r : regions) depth = std::max(depth, r.deactivate); 
+    return depth; 
+} 
+
+// Waybar gives up its exclusive zone while hidden, so a refresh then keeps
+// the reserved area each monitor had with the bar shown. 
+void refresh_monitors(std::vector<Monitor>& monitors) { 
+    std::vector<Monitor> fresh = backend->get_monitors(); 
+    if (!is_bar_visible) { 
+        for (auto& m : fresh) { 
+            for (const auto& old : monitors) { 
+                if (old.name == m.name) m.reserved = old.reserved; 
+            } 
+        } 
+    } 
+    monitors = std::move(fresh); 
+} 
+
+// Schedules cursor samples for the polling fallback. The next sample comes
+// after half the time the pointer needs to reach the point where the bar
+// toggles, at its recent speed but never assuming less than a quick flick,
+// so sampling tightens near the edge and backs off when far away. A pointer
+// resting near the edge is sampled a little less often, but never so rarely
+// that a reveal would feel late. 
+class CursorSampler { 
+private: 
+    using Clock = std::chrono::steady_clock; 
+
+    static constexpr double FLICK_SPEED = 2.0;   // px per ms 
+    static constexpr int MAX_DELAY_MS = 500; 
+    static constexpr int IDLE_AFTER_MS = 2000; 
+    static constexpr int IDLE_MAX_DELAY_MS = 100; 
+
+    bool has_last = false; 
+    int last_x = 0, last_y = 0; 
+    double speed = 0.0; 
+    Clock::time_point last_time, last_motion; 
+
+    static double ms_between(Clock::time_point a, Clock::time_point b) { 
+        return std::chrono::duration<double, std::milli>(b - a).count(); 
+    } 
+
+public: 
+    static constexpr int REVEAL_MIN_DELAY_MS = 20; 
+    static constexpr int HIDE_MIN_DELAY_MS = 50; 
+
+    uint64_t samples = 0; 
+    Clock::time_point started = Clock::now(); 
+
+    // Records a sample at (cx, cy) and returns the delay until the next one. 
+    int next_delay(int cx, int cy, int distance, int min_delay) { 
+        Clock::time_point now = Clock::now(); 
+        samples++; 
+
+        if (has_last) { 
+            double moved = std::hypot(cx - last_x, cy - last_y); 
+            speed = std::max(moved / std::max(ms_between(last_time, now), 1.0), speed * 0.5); 
+            if (moved > 0) last_motion = now; 
+        } else { 
+            last_motion = now; 
+        } 
+        has_last = true; 
+        last_x = cx; 
+        last_y = cy; 
+        last_time = now; 
+
+        double delay = distance / std::max(speed, FLICK_SPEED) / 2.0; 
+        double still_ms = ms_between(last_motion, now); 
+        if (still_ms >= IDLE_AFTER_MS) delay = std::max(delay, std::min(still_ms / 4.0, static_cast<double>(IDLE_MAX_DELAY_MS))); 
+        return std::clamp(static_cast<int>(delay), min_delay, MAX_DELAY_MS); 
+    } 
+
+    // Counts a failed sample; without a position there is nothing to adapt to. 
+    int missed() { 
+        samples++; 
+        return MAX_DELAY_MS; 
+    } 
+
+    void report() const { 
+        double seconds = ms_between(started, Clock::now()) / 1000.0; 
+        std::cerr << "navbar-hover: " << samples << " cursor samples in " << static_cast<long>(seconds) 
+                  << " s (" << (seconds > 0 ? samples / seconds : 0.0) << "/s)\n"; 
+    } 
+}; 
+
+EdgeTrigger::Edge edge_for(const std::string& bar_position) { 
+    if (bar_position == "bottom") return EdgeTrigger::Edge::Bottom; 
+    if (bar_position == "left") return EdgeTrigger::Edge::Left; 
+    if (bar_position == "right") return EdgeTrigger::Edge::Right; 
+    return EdgeTrigger::Edge::Top; 
+} 
 
+std::string config_path() { 
     std::string cache_home;
     const char* xdg_env = std::getenv("XDG_CACHE_HOME");
     
@@ -180,12 +428,16 @@ std::optional<Config> read_config() {
         const char* home_env = std::getenv("HOME");
         if (!home_env) {
             std::cerr << "Error: Neither XDG_CONFIG_HOME nor HOME environment variables are set.\n";
-            return std::nullopt;
+            return "";
         }
         cache_home = std::string(home_env) + "/.cache";
     }
-    
-    std::ifstream file(cache_home + "/nekoroshell/navbar-hover.conf"); 
+    return cache_home + "/nekoroshell/navbar-hover.conf"; 
+} 
+
+std::optional<Config> read_config(const std::string& path) { 
+    Config cfg;
+    std::ifstream file(path); 
     if (!file.is_open()) return std::nullopt;
      
     if (file.is_open()) { 
@@ -203,94 +455,166 @@ std::optional<Config> read_config() {
 } 
 
 int main() { 
+    auto launched = std::chrono::steady_clock::now(); 
     if (getenv("HYPRLAND_INSTANCE_SIGNATURE")) backend = std::make_unique<HyprlandBackend>(); 
     else if (getenv("SWAYSOCK")) backend = std::make_unique<SwayBackend>(); 
     else return 1; 
 
-    while (backend->is_layer_active("swaync-control-center")) { 
-        std::this_thread::sleep_for(std::chrono::milliseconds(150)); 
+    event_loop.add_signal(SIGTERM, []() { event_loop.stop(); }); 
+    event_loop.add_signal(SIGINT, []() { event_loop.stop(); }); 
+
+    // Hide the bar the moment the control center opens. A Waybar we started
+    // is ready for toggles once its bar maps. 
+    bool watching = backend->watch_layers(event_loop, [](std::string_view layer) { 
+        if (layer == "waybar") { 
+            if (!is_waybar_ready && waybar.running() && backend->is_layer_active("waybar")) { 
+                is_waybar_ready = true; 
+                event_loop.set_timer(ready_timer, 0, false); 
+            } 
+            return; 
+        } 
+        is_swaync_open = backend->is_layer_active("swaync-control-center"); 
+        if (is_swaync_open && is_bar_visible && waybar.running()) toggle_waybar(false); 
+    }); 
+    if (!watching) { 
+        log_error("Could not watch layer surfaces."); 
+        return 1; 
     } 
 
-    std::thread(swaync_watcher_thread).detach(); 
+    event_loop.run_until([]() { return !backend->is_layer_active("swaync-control-center"); }, -1); 
+    if (event_loop.is_stopped()) return 0; 
 
-    auto result = read_config();
+    std::string cfg_path = config_path(); 
+    auto result = read_config(cfg_path);
     if (!result) {
         return 1;
     }
     Config cfg = *result;
-    std::vector<Monitor> monitors = backend->get_monitors(); 
-    int cycle_count = 0; 
-
-    int ret = system("killall -q waybar"); 
-    (void)ret;
-     
-    for (int i = 0; i < 40; ++i) {  
-        if (get_waybar_pid() <= 0) break; 
-        std::this_thread::sleep_for(std::chrono::milliseconds(50)); 
+    std::vector<Monitor> monitors; 
+    std::vector<EdgeRegion> edge_regions; 
+    auto update_regions = [&monitors, &edge_regions, &cfg]() { 
+        edge_regions = build_edge_regions(monitors, cfg); 
+        if (edge_trigger) edge_trigger->reconfigure(edge_for(cfg.bar_position), cfg.activate_size, hide_depth(edge_regions, cfg)); 
+    }; 
+
+    // A reload is applied between two loop callbacks, so nothing sees half
+    // of it. 
+    FileWatch config_watch(event_loop); 
+    bool watching_config = config_watch.watch(cfg_path, [&cfg, &update_regions, cfg_path]() { 
+        auto reloaded = read_config(cfg_path); 
+        if (!reloaded) return; 
+        cfg = *reloaded; 
+        update_regions(); 
+    }); 
+    if (!watching_config) log_error("Could not watch " + cfg_path + ", config changes need a restart."); 
+
+    // Reuse a running Waybar, such as one left behind by a previous
+    // navbar-hover; /proc is only scanned this once. A hidden Waybar keeps its
+    // layer mapped, so its state cannot be read back. Instead every daemon
+    // that toggles it shows the bar again when it exits, and an adopted bar
+    // is taken as shown. Only a freshly spawned bar is waited for, and only
+    // until it is ready. 
+    waybar.on_exit = waybar_exited; 
+    ready_timer = event_loop.add_timer(0, false, []() { 
+        if (backend->sees_bar_layer() && !backend->is_layer_active("waybar")) log_error("Waybar did not map its bar within 5 s."); 
+        is_waybar_ready = waybar.running(); 
+    }); 
+    respawn_timer = event_loop.add_timer(0, false, []() { start_waybar(); }); 
+    bool adopted = waybar.adopt() > 0; 
+    if (adopted) { 
+        waybar_started = std::chrono::steady_clock::now(); 
+        is_waybar_ready = true; 
+    } else { 
+        start_waybar(); 
+        event_loop.run_until([]() { return is_waybar_ready || !waybar.running(); }, -1); 
+        if (event_loop.is_stopped()) return 0; 
     } 
-
-    pid_t pid = fork(); 
-    if (pid == 0) { 
-        char* args[] = {(char*)"waybar", nullptr}; 
-        execvp(args[0], args); 
-        std::ofstream log_file("/tmp/nekoroshell-navbar.log", std::ios_base::app);
-        log_file << "[FATAL] execvp failed to spawn Waybar. Error code: " << errno << "\n";
-        exit(1);
-    } 
-
-    for (int i = 0; i < 40; ++i) {  
-        std::this_thread::sleep_for(std::chrono::milliseconds(150)); 
-        if (backend->is_layer_active("waybar")) break; 
-    } 
-     
-    std::this_thread::sleep_for(std::chrono::milliseconds(1000)); 
-
-    is_bar_visible = true; 
-    current_waybar_pid = pid; 
-
-    while (true) { 
-        if (current_waybar_pid > 0 && kill(current_waybar_pid, 0) != 0) current_waybar_pid = -1; 
-        if (current_waybar_pid <= 0) { 
-            pid_t new_pid = get_waybar_pid(); 
-            if (new_pid > 0) { 
-                current_waybar_pid = new_pid; 
-                is_bar_visible = true;  
-            } 
+    auto ready_ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - launched); 
+    std::cerr << "navbar-hover: ready in " << ready_ms.count() << " ms (" << (adopted ? "adopted" : "spawned") << " Waybar)\n"; 
+
+    // Geometry is read once the bar is up, so its exclusive zone shows in the
+    // reserved area, and again whenever the outputs change. 
+    refresh_monitors(monitors); 
+    update_regions(); 
+    backend->watch_monitors([&monitors, &update_regions]() { 
+        refresh_monitors(monitors); 
+        update_regions(); 
+    }); 
+
+    CursorSampler sampler; 
+    event_loop.add_signal(SIGUSR2, [&sampler]() { sampler.report(); }); 
+
+    // With a trigger strip the cursor is only sampled while the bar is shown:
+    // the strip sees the pointer reach the edge, but not leave the bar
+    // sideways or onto another output. 
+    int sample_timer = -1; 
+    sample_timer = event_loop.add_timer(CursorSampler::REVEAL_MIN_DELAY_MS, false, [&]() { 
+        if (edge_trigger && !is_bar_visible) return; 
+        if (is_swaync_open) { 
+            event_loop.set_timer(sample_timer, CursorSampler::HIDE_MIN_DELAY_MS, false); 
+            return; 
         } 
 
-        if (is_swaync_open_flag.load()) { 
-            if (is_bar_visible) toggle_waybar(false); 
-            std::this_thread::sleep_for(std::chrono::milliseconds(50)); 
-            continue;  
+        int cx = 0, cy = 0; 
+        // A backend without cursor positions (Sway) leaves the strip alone
+        // in charge. 
+        if (!backend->get_cursor_pos(cx, cy)) { 
+            if (!edge_trigger) event_loop.set_timer(sample_timer, sampler.missed(), false); 
+            return; 
         } 
 
-        if (++cycle_count >= 100) { 
-            cfg = *result;
-            monitors = backend->get_monitors(); 
-            cycle_count = 0; 
+        // While hidden, the bar toggles once the cursor is within activate_size
+        // of the edge; while shown, once it is further than deactivate_size or
+        // the reserved area, whichever is wider. 
+        // margin is how far inside the toggle depth the cursor is. 
+        bool over_edge = false; 
+        int margin = 0; 
+        for (const auto& r : edge_regions) { 
+            int along = r.along_x ? cx : cy; 
+            if (along < r.lo || along >= r.hi) continue; 
+            int depth = ((r.along_x ? cy : cx) - r.edge) * r.sign; 
+            if (depth < 0) continue; 
+            int inside = (is_bar_visible ? r.deactivate : r.activate) - depth; 
+            if (!over_edge || inside > margin) margin = inside; 
+            over_edge = true; 
         } 
-
-        int cx = 0, cy = 0; 
-        if (backend->get_cursor_pos(cx, cy)) { 
-            int thresh = is_bar_visible ? cfg.deactivate_size : cfg.activate_size; 
-            bool is_hovering = false; 
-
-            for (const auto& m : monitors) { 
-                bool match = false; 
-                if (cfg.bar_position == "top") match = (cx >= m.x && cx < m.x + m.w && cy >= m.y && cy <= m.y + thresh); 
-                else if (cfg.bar_position == "bottom") match = (cx >= m.x && cx < m.x + m.w && cy >= m.y + m.h - thresh && cy <= m.y + m.h); 
-                else if (cfg.bar_position == "left") match = (cx >= m.x && cx <= m.x + thresh && cy >= m.y && cy < m.y + m.h); 
-                else if (cfg.bar_position == "right") match = (cx >= m.x + m.w - thresh && cx <= m.x + m.w && cy >= m.y && cy < m.y + m.h); 
-                 
-                if (match) { is_hovering = true; break; } 
+        bool is_hovering = over_edge && margin >= 0; 
+
+        if (is_hovering && !is_bar_visible) toggle_waybar(true); 
+        else if (!is_hovering && is_bar_visible) toggle_waybar(false); 
+
+        int distance; 
+        if (is_bar_visible) distance = is_hovering ? margin : 0; 
+        else distance = over_edge ? -margin : 2000; 
+
+        int min_delay = is_bar_visible ? CursorSampler::HIDE_MIN_DELAY_MS : CursorSampler::REVEAL_MIN_DELAY_MS; 
+        event_loop.set_timer(sample_timer, sampler.next_delay(cx, cy, distance, min_delay), false); 
+    }); 
+
+    // Prefer a layer-shell trigger strip, which works on any wlroots-style
+    // compositor and costs nothing while the pointer is elsewhere. Cursor
+    // polling through the backend remains the fallback. 
+    edge_trigger = std::make_unique<EdgeTrigger>(); 
+    edge_trigger->on_enter = [&sample_timer]() { 
+        if (is_swaync_open) return; 
+        toggle_waybar(!is_bar_visible); 
+        if (is_bar_visible) event_loop.set_timer(sample_timer, CursorSampler::HIDE_MIN_DELAY_MS, false); 
+    }; 
+    if (edge_trigger->connect(edge_for(cfg.bar_position), cfg.activate_size, hide_depth(edge_regions, cfg))) { 
+        edge_trigger->set_bar_visible(is_bar_visible); 
+        event_loop.add_fd(edge_trigger->fd(), EPOLLIN, [](uint32_t) { 
+            if (!edge_trigger->dispatch()) { 
+                log_error("Lost the Wayland connection."); 
+                event_loop.stop(); 
             } 
-
-            if (is_hovering && !is_bar_visible) toggle_waybar(true); 
-            else if (!is_hovering && is_bar_visible) toggle_waybar(false); 
-        } 
-
-        std::this_thread::sleep_for(std::chrono::milliseconds(50)); 
+        }); 
+    } else { 
+        edge_trigger.reset(); 
     } 
 
+    event_loop.run(); 
+    if (!is_bar_visible && waybar.running()) waybar.signal(SIGUSR1); 
+    sampler.report(); 
+
     return 0; 
-}
+}
\ No newline at end of file
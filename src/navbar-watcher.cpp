@@ -1,150 +1,155 @@
 #include <iostream>
-#include <fstream>
 #include <cerrno>
 #include <csignal>
 #include <sys/wait.h>
 #include <vector>
 #include <string>
+#include <string_view>
 #include <cstring>
 #include <unistd.h>
 #include <sys/socket.h>
 #include <sys/un.h>
-#include <thread>
-#include <chrono>
+#include <sys/epoll.h>
 #include <memory>
 #include <cstdlib>
 #include <cstdio>
 #include <algorithm>
+#include <charconv>
 #include <set>
 #include <functional>
 #include <unordered_map>
-#include <unordered_set>
-#include <sstream>
-#include <dirent.h>
-#include <nlohmann/json.hpp>
-
-using json = nlohmann::json;
-
-struct PipeDeleter {
-    void operator()(FILE* stream) const { if (stream) pclose(stream); }
-};
-
-std::string exec(const char* cmd) {
-    char buffer[4096];
-    std::string result = "";
-    std::unique_ptr<FILE, PipeDeleter> pipe(popen(cmd, "r"));
-    if (!pipe) return "";
-    while (fgets(buffer, sizeof(buffer), pipe.get()) != nullptr) {
-        result += buffer;
-    }
-    return result;
-}
-
-pid_t get_waybar_pid() {
-    DIR* dir = opendir("/proc");
-    if (!dir) return -1;
-    struct dirent* ent;
-    while ((ent = readdir(dir)) != nullptr) {
-        if (!isdigit(ent->d_name[0])) continue;
-        std::string pid_str = ent->d_name;
-        std::ifstream comm_file("/proc/" + pid_str + "/comm");
-        if (comm_file.is_open()) {
-            std::string comm_name;
-            std::getline(comm_file, comm_name);
-            if (comm_name == "waybar") {
-                closedir(dir);
-                return std::stoi(pid_str);
-            }
-        }
-    }
-    closedir(dir);
-    return -1;
-}
+#include "hyprland-ipc.hpp"
+#include "line-reader.hpp"
+#include "hyprland-events.hpp"
+#include "json-reader.hpp"
+#include "event-loop.hpp"
+#include "event-socket.hpp"
+#include "process-supervisor.hpp"
 
 class CompositorBackend {
 public:
     virtual ~CompositorBackend() = default;
-    virtual bool is_layer_active(const std::string& layer_name) = 0;
     virtual bool has_active_windows() = 0;
-    virtual void listen_for_events(std::function<void()> on_event) = 0;
+    // Registers the compositor's event source on loop. on_event runs once per
+    // batch of relevant events; the loop is stopped when the source closes.
+    virtual bool listen_for_events(EventLoop& loop, std::function<void()> on_event) = 0;
 };
 
 class HyprlandBackend : public CompositorBackend {
 private:
-    std::unordered_map<std::string, std::string> window_to_workspace;
-    std::unordered_map<std::string, int> workspace_window_count;
-    std::unordered_set<std::string> active_workspaces;
-
-    std::vector<std::string> split(const std::string& s, char delimiter) {
-        std::vector<std::string> tokens;
-        std::string token;
-        std::istringstream tokenStream(s);
-        while (std::getline(tokenStream, token, delimiter)) tokens.push_back(token);
-        return tokens;
-    }
+    HyprlandIPC ipc;
+    int event_fd = -1;
+    LineReader events;
+    EventDispatcher dispatcher;
+    bool state_changed = false;
+    bool needs_resync = false;
+
+    // Keyed like socket2 events: decoded window addresses and workspace ids.
+    // Names are only kept to place openwindow events, which carry no id.
+    std::unordered_map<uint64_t, int> window_workspace;
+    std::unordered_map<int, int> workspace_window_count;
+    std::unordered_map<std::string, int> workspace_ids;
+    std::unordered_map<std::string, int> monitor_workspace;
+    std::string focused_monitor;
+
+    // Rebuilds every index from one batched snapshot, so monitors and
+    // clients describe the same moment. A failed read keeps the
+    // current state.
+    void sync_state_from_json() {
+        HyprlandSnapshot snapshot;
+        if (!ipc.snapshot(snapshot)) return;
 
-    std::string hyprland_ipc_request(const std::string& command) {
-        const char* runtime_dir = getenv("XDG_RUNTIME_DIR");
-        const char* signature = getenv("HYPRLAND_INSTANCE_SIGNATURE");
-        if (!runtime_dir || !signature) return "";
-    
-        std::string socket_path = std::string(runtime_dir) + "/hypr/" + std::string(signature) + "/.socket.sock";
-        
-        int sfd = socket(AF_UNIX, SOCK_STREAM, 0);
-        if (sfd == -1) return "";
-    
-        struct sockaddr_un addr;
-        memset(&addr, 0, sizeof(struct sockaddr_un));
-        addr.sun_family = AF_UNIX;
-        strncpy(addr.sun_path, socket_path.c_str(), sizeof(addr.sun_path) - 1);
-    
-        if (connect(sfd, (struct sockaddr *) &addr, sizeof(struct sockaddr_un)) == -1) {
-            close(sfd);
-            return "";
+        window_workspace.clear();
+        workspace_window_count.clear();
+        workspace_ids.clear();
+        monitor_workspace.clear();
+        focused_monitor.clear();
+
+        for (const auto& workspace : snapshot.workspaces) {
+            workspace_ids[workspace.name] = workspace.id;
         }
-    
-        if (write(sfd, command.c_str(), command.length()) == -1) {
-            close(sfd);
-            return "";
+        for (const auto& monitor : snapshot.monitors) {
+            if (monitor.active_workspace == -999) continue;
+            monitor_workspace[monitor.name] = monitor.active_workspace;
+            workspace_ids[monitor.active_workspace_name] = monitor.active_workspace;
+            if (monitor.focused) focused_monitor = monitor.name;
         }
-    
-        char buffer[8192];
-        std::string response = "";
-        ssize_t bytes_read;
-        while ((bytes_read = read(sfd, buffer, sizeof(buffer) - 1)) > 0) {
-            buffer[bytes_read] = '\0';
-            response += buffer;
+        for (const auto& client : snapshot.clients) {
+            if (client.workspace == -999) continue;
+            workspace_ids[client.workspace_name] = client.workspace;
+            add_window(client.address, client.workspace);
         }
-        
-        close(sfd);
-        return response;
     }
 
-    void sync_state_from_json() {
-        try {
-            window_to_workspace.clear();
-            workspace_window_count.clear();
-            active_workspaces.clear();
-    
-            std::string mon_out = hyprland_ipc_request("j/monitors");
-            if (!mon_out.empty() && mon_out.front() == '[') {
-                auto monitors = json::parse(mon_out);
-                for (const auto& mon : monitors) {
-                    active_workspaces.insert(mon["activeWorkspace"]["name"].get<std::string>());
-                }
+    void add_window(uint64_t address, int workspace_id) {
+        window_workspace[address] = workspace_id;
+        workspace_window_count[workspace_id]++;
+    }
+
+    bool remove_window(uint64_t address) {
+        auto it = window_workspace.find(address);
+        if (it == window_workspace.end()) return false;
+        if (--workspace_window_count[it->second] <= 0) workspace_window_count.erase(it->second);
+        window_workspace.erase(it);
+        return true;
+    }
+
+    void register_handlers() {
+        dispatcher.on<OpenWindowEvent>([this](const OpenWindowEvent& event) {
+            auto ws = workspace_ids.find(std::string(event.workspace));
+            if (ws == workspace_ids.end()) {
+                needs_resync = true;
+                return;
             }
-    
-            std::string cli_out = hyprland_ipc_request("j/clients");
-            if (!cli_out.empty() && cli_out.front() == '[') {
-                auto clients = json::parse(cli_out);
-                for (const auto& client : clients) {
-                    std::string addr = client["address"].get<std::string>();
-                    std::string ws = client["workspace"]["name"].get<std::string>();
-                    window_to_workspace[addr] = ws;
-                    workspace_window_count[ws]++;
-                }
+            uint64_t address = parse_address(event.address);
+            remove_window(address);
+            add_window(address, ws->second);
+            state_changed = true;
+        });
+        dispatcher.on<CloseWindowEvent>([this](const CloseWindowEvent& event) {
+            if (remove_window(parse_address(event.address))) state_changed = true;
+        });
+        dispatcher.on<MoveWindowV2Event>([this](const MoveWindowV2Event& event) {
+            uint64_t address = parse_address(event.address);
+            if (!remove_window(address)) needs_resync = true;
+            add_window(address, event.workspace_id);
+            workspace_ids[std::string(event.workspace)] = event.workspace_id;
+            state_changed = true;
+        });
+
+        // workspacev2 always refers to the focused monitor, which focusedmonv2
+        // keeps current.
+        dispatcher.on<WorkspaceV2Event>([this](const WorkspaceV2Event& event) {
+            workspace_ids[std::string(event.workspace)] = event.workspace_id;
+            if (focused_monitor.empty()) needs_resync = true;
+            else monitor_workspace[focused_monitor] = event.workspace_id;
+            state_changed = true;
+        });
+        dispatcher.on<FocusedMonV2Event>([this](const FocusedMonV2Event& event) {
+            focused_monitor = std::string(event.monitor);
+            monitor_workspace[focused_monitor] = event.workspace_id;
+            state_changed = true;
+        });
+        dispatcher.on<CreateWorkspaceV2Event>([this](const CreateWorkspaceV2Event& event) {
+            workspace_ids[std::string(event.workspace)] = event.workspace_id;
+        });
+        dispatcher.on<RenameWorkspaceEvent>([this](const RenameWorkspaceEvent& event) {
+            for (auto it = workspace_ids.begin(); it != workspace_ids.end();) {
+                if (it->second == event.workspace_id) it = workspace_ids.erase(it);
+                else ++it;
             }
-        } catch (...) {}
+            workspace_ids[std::string(event.workspace)] = event.workspace_id;
+        });
+        dispatcher.on<DestroyWorkspaceV2Event>([this](const DestroyWorkspaceV2Event& event) {
+            workspace_ids.erase(std::string(event.workspace));
+        });
+
+        // Rare topology changes move workspaces between monitors without
+        // saying which becomes active; those are read back in full.
+        auto resync = [this](std::string_view) { needs_resync = true; };
+        dispatcher.on(HyprEvent::MoveWorkspaceV2, resync);
+        dispatcher.on(HyprEvent::MonitorAddedV2, resync);
+        dispatcher.on(HyprEvent::MonitorRemovedV2, resync);
     }
 
 public:
@@ -152,100 +157,54 @@ public:
         sync_state_from_json();
     }
 
-    bool is_layer_active(const std::string& layer_name) override {
-        std::string layers = exec("hyprctl layers");
-        return (layers.find(layer_name) != std::string::npos);
-    }
-
     bool has_active_windows() override {
-        for (const auto& ws : active_workspaces) {
-            if (workspace_window_count[ws] > 0) return true;
+        for (const auto& monitor : monitor_workspace) {
+            if (workspace_window_count.count(monitor.second)) return true;
         }
         return false;
     }
 
-    void listen_for_events(std::function<void()> on_event) override {
-        const char* runtime_dir = getenv("XDG_RUNTIME_DIR");
-        const char* signature = getenv("HYPRLAND_INSTANCE_SIGNATURE");
-        if (!runtime_dir || !signature) return;
-
-        std::string socket_path = std::string(runtime_dir) + "/hypr/" + std::string(signature) + "/.socket2.sock";
-        
-        struct sockaddr_un addr;
-        int sfd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0);
-        if (sfd == -1) return;
-
-        memset(&addr, 0, sizeof(struct sockaddr_un));
-        addr.sun_family = AF_UNIX;
-        strncpy(addr.sun_path, socket_path.c_str(), sizeof(addr.sun_path) - 1);
+    bool listen_for_events(EventLoop& loop, std::function<void()> on_event) override {
+        event_fd = ipc.connect_events(SOCK_NONBLOCK);
+        if (event_fd == -1) return false;
 
-        if (connect(sfd, (struct sockaddr *) &addr, sizeof(struct sockaddr_un)) == -1) {
-            close(sfd);
-            return;
-        }
+        register_handlers();
 
-        char buffer[4096];
-        std::string pending_data = "";
-        
-        while (true) {
-            ssize_t num_read = read(sfd, buffer, sizeof(buffer) - 1);
-            if (num_read > 0) {
-                buffer[num_read] = '\0';
-                pending_data += buffer;
-                
-                size_t pos = 0;
-                bool state_changed = false;
-                
-                while ((pos = pending_data.find('\n')) != std::string::npos) {
-                    std::string line = pending_data.substr(0, pos);
-                    pending_data.erase(0, pos + 1);
-                    
-                    if (line.rfind("openwindow>>", 0) == 0) {
-                        auto parts = split(line.substr(12), ',');
-                        if (parts.size() >= 2) {
-                            window_to_workspace[parts[0]] = parts[1];
-                            workspace_window_count[parts[1]]++;
-                            state_changed = true;
-                        }
-                    } 
-                    else if (line.rfind("closewindow>>", 0) == 0) {
-                        std::string addr = line.substr(13);
-                        if (window_to_workspace.count(addr)) {
-                            workspace_window_count[window_to_workspace[addr]]--;
-                            window_to_workspace.erase(addr);
-                            state_changed = true;
-                        }
-                    } 
-                    else if (line.rfind("movewindow>>", 0) == 0) {
-                        auto parts = split(line.substr(12), ',');
-                        if (parts.size() >= 2) {
-                            std::string addr = parts[0];
-                            std::string new_ws = parts[1];
-                            if (window_to_workspace.count(addr)) workspace_window_count[window_to_workspace[addr]]--;
-                            window_to_workspace[addr] = new_ws;
-                            workspace_window_count[new_ws]++;
-                            state_changed = true;
-                        }
-                    }
-                    else if (line.rfind("workspace>>", 0) == 0 || line.rfind("focusedmon>>", 0) == 0) {
-                        sync_state_from_json();
-                        state_changed = true;
-                    }
-                }
-                
-                if (state_changed) on_event(); 
-            } else if (num_read == -1) {
-                if (errno == EAGAIN || errno == EWOULDBLOCK) {
-                    std::this_thread::sleep_for(std::chrono::milliseconds(100));
-                } else break;
-            } else break;
-        }
-        close(sfd);
+        auto on_batch = [this, on_event]() {
+            if (needs_resync) {
+                needs_resync = false;
+                sync_state_from_json();
+                state_changed = true;
+            }
+            if (state_changed) on_event();
+            state_changed = false;
+        };
+        return add_event_socket(loop, event_fd, events, dispatcher, on_batch, [this, &loop]() {
+            close(event_fd);
+            event_fd = -1;
+            loop.stop();
+        });
     }
 };
 
 class SwayBackend : public CompositorBackend {
 private:
+    static constexpr uint32_t GET_WORKSPACES = 1;
+    static constexpr uint32_t SUBSCRIBE = 2;
+    static constexpr uint32_t GET_TREE = 4;
+    static constexpr uint32_t EVENT_WORKSPACE = 0x80000000;
+    static constexpr uint32_t EVENT_WINDOW = 0x80000003;
+
+    int command_fd = -1;
+    int event_fd = -1;
+    std::string event_body;
+
+    // The workspace every window (tiled or floating) is on, by container id,
+    // and the number of windows on each workspace.
+    std::unordered_map<int, int> window_workspace;
+    std::unordered_map<int, int> workspace_windows;
+    int focused_workspace = -1;
+
     int get_socket() {
         const char* sock_path = getenv("SWAYSOCK");
         if (!sock_path) return -1;
@@ -282,141 +241,292 @@ private:
         return response;
     }
 
-    bool has_windows_recursive(const json& j) {
-        if (j.contains("type") && j["type"] == "workspace" && j.value("focused", false)) {
-            size_t count = 0;
-            if (j.contains("nodes")) count += j["nodes"].size();
-            if (j.contains("floating_nodes")) count += j["floating_nodes"].size();
-            return count > 0;
+    // Sends a request over the long-lived command connection, reconnecting
+    // once if Sway dropped it.
+    std::string command(uint32_t type, const std::string& payload = "") {
+        for (int attempt = 0; attempt < 2; ++attempt) {
+            if (command_fd == -1) command_fd = get_socket();
+            if (command_fd == -1) return "";
+            std::string reply = sway_ipc_request(command_fd, type, payload);
+            if (!reply.empty()) return reply;
+            close(command_fd);
+            command_fd = -1;
         }
-        if (j.contains("nodes")) {
-            for (const auto& node : j["nodes"]) {
-                if (has_windows_recursive(node)) return true;
+        return "";
+    }
+
+    void add_window(int id, int workspace) {
+        auto it = window_workspace.find(id);
+        if (it != window_workspace.end()) {
+            if (it->second == workspace) return;
+            --workspace_windows[it->second];
+        }
+        window_workspace[id] = workspace;
+        ++workspace_windows[workspace];
+    }
+
+    bool remove_window(int id) {
+        auto it = window_workspace.find(id);
+        if (it == window_workspace.end()) return false;
+        --workspace_windows[it->second];
+        window_workspace.erase(it);
+        return true;
+    }
+
+    // Walks a GET_TREE node and records every leaf container under the
+    // workspace it sits in. Sway writes "id" and "type" before the child
+    // arrays, so the workspace is known by the time its children are read.
+    void collect_windows(JsonReader& reader, int workspace) {
+        if (!reader.enter_object()) return;
+        int id = 0, children = 0;
+        std::string_view key, type;
+        while (reader.next_member(key)) {
+            if (key == "id") reader.read_int(id);
+            else if (key == "type") reader.read_string(type);
+            else if (key == "nodes" || key == "floating_nodes") {
+                if (type == "workspace") workspace = id;
+                if (!reader.enter_array()) continue;
+                while (reader.next_element()) {
+                    collect_windows(reader, workspace);
+                    ++children;
+                }
             }
+            else reader.skip();
         }
-        return false;
+        if (children == 0 && workspace != 0 && (type == "con" || type == "floating_con")) {
+            add_window(id, workspace);
+        }
+    }
+
+    // Rebuilds the window map from the tree and the focused workspace from
+    // the workspace list. Only needed on startup, on a reload and when a
+    // window moves somewhere its event does not name.
+    void sync_windows() {
+        window_workspace.clear();
+        workspace_windows.clear();
+        focused_workspace = -1;
+
+        std::string tree = command(GET_TREE);
+        JsonReader tree_reader(tree);
+        collect_windows(tree_reader, 0);
+
+        std::string reply = command(GET_WORKSPACES);
+        JsonReader reader(reply);
+        if (!reader.enter_array()) return;
+        while (reader.next_element()) {
+            if (!reader.enter_object()) continue;
+            int id = 0;
+            bool focused = false;
+            std::string_view key;
+            while (reader.next_member(key)) {
+                if (key == "id") reader.read_int(id);
+                else if (key == "focused") reader.read_bool(focused);
+                else reader.skip();
+            }
+            if (focused) focused_workspace = id;
+        }
+    }
+
+    // Workspace events only move the focus; a reload starts over.
+    void apply_workspace_event() {
+        JsonReader reader(event_body);
+        if (!reader.enter_object()) return;
+
+        std::string_view key, change;
+        int current_id = 0;
+        bool has_current = false;
+        while (reader.next_member(key)) {
+            if (key == "change") reader.read_string(change);
+            else if (key == "current") has_current = reader.read_member_int("id", current_id);
+            else reader.skip();
+        }
+
+        if (change == "reload") sync_windows();
+        else if (change == "focus" && has_current) focused_workspace = current_id;
+    }
+
+    // Applies a window event from its body. A new window opens on the focused
+    // workspace and a closed one leaves the workspace it was recorded on; a
+    // floating toggle keeps its workspace. Only moves, and new windows that
+    // did not open where they can be seen (assign rules), re-read the tree.
+    // Returns true if any count may have changed.
+    bool apply_window_event() {
+        JsonReader reader(event_body);
+        if (!reader.enter_object()) return false;
+
+        std::string_view key, change;
+        int id = 0;
+        bool has_id = false, visible = false;
+        while (reader.next_member(key)) {
+            if (key == "change") reader.read_string(change);
+            else if (key == "container") {
+                if (!reader.enter_object()) continue;
+                while (reader.next_member(key)) {
+                    if (key == "id") has_id = reader.read_int(id);
+                    else if (key == "visible") reader.read_bool(visible);
+                    else reader.skip();
+                }
+            }
+            else reader.skip();
+        }
+
+        if (change == "close") return has_id && remove_window(id);
+        if (change == "new" && has_id && visible && focused_workspace != -1) {
+            add_window(id, focused_workspace);
+            return true;
+        }
+        if (change != "new" && change != "move") return false;
+        sync_windows();
+        return true;
+    }
+
+    bool read_event(uint32_t& type) {
+        struct { char magic[6]; uint32_t len; uint32_t type; } __attribute__((packed)) header;
+        if (read(event_fd, &header, sizeof(header)) != sizeof(header)) return false;
+
+        event_body.resize(header.len);
+        size_t total_read = 0;
+        while (total_read < header.len) {
+            ssize_t bytes = read(event_fd, &event_body[total_read], header.len - total_read);
+            if (bytes <= 0) return false;
+            total_read += bytes;
+        }
+        type = header.type;
+        return true;
     }
 
 public:
-    bool is_layer_active(const std::string& layer_name) override {
-        std::string cmd = "lswt -j 2>/dev/null | jq -e '.[] | select(.namespace == \"" + layer_name + "\")' >/dev/null 2>&1";
-        return system(cmd.c_str()) == 0;
+    SwayBackend() {
+        sync_windows();
+    }
+
+    ~SwayBackend() override {
+        if (command_fd != -1) close(command_fd);
     }
 
     bool has_active_windows() override {
-        int fd = get_socket();
-        if (fd == -1) return false;
-        
-        std::string tree_json = sway_ipc_request(fd, 4); 
-        close(fd);
-        
-        if (tree_json.empty()) return false;
-        try {
-            auto j = json::parse(tree_json);
-            return has_windows_recursive(j);
-        } catch (...) { return false; }
+        auto it = workspace_windows.find(focused_workspace);
+        return it != workspace_windows.end() && it->second > 0;
     }
 
-    void listen_for_events(std::function<void()> on_event) override {
-        int fd = get_socket();
-        if (fd == -1) return;
+    bool listen_for_events(EventLoop& loop, std::function<void()> on_event) override {
+        event_fd = get_socket();
+        if (event_fd == -1) return false;
         
-        sway_ipc_request(fd, 2, "[\"window\", \"workspace\"]");
+        sway_ipc_request(event_fd, SUBSCRIBE, "[\"window\", \"workspace\"]");
+        // Anything that changed before the subscription took effect.
+        sync_windows();
         
-        struct { char magic[6]; uint32_t len; uint32_t type; } __attribute__((packed)) header;
-        std::vector<char> buffer(65536);
-        
-        while (true) {
-            if (read(fd, &header, sizeof(header)) != sizeof(header)) break;
-            
-            size_t total_read = 0;
-            while (total_read < header.len) {
-                ssize_t bytes = read(fd, buffer.data(), std::min(buffer.size(), (size_t)(header.len - total_read)));
-                if (bytes <= 0) break;
-                total_read += bytes;
+        return loop.add_fd(event_fd, EPOLLIN, [this, &loop, on_event](uint32_t) {
+            uint32_t type = 0;
+            if (!read_event(type)) {
+                loop.remove_fd(event_fd);
+                close(event_fd);
+                event_fd = -1;
+                loop.stop();
+                return;
             }
-            
-            if ((header.type & 0x80000000) != 0) {
+            if (type == EVENT_WORKSPACE) {
+                apply_workspace_event();
+                on_event();
+            } else if (type == EVENT_WINDOW && apply_window_event()) {
                 on_event();
             }
-        }
-        close(fd);
+        });
     }
 };
 
 class MangoBackend : public CompositorBackend {
+private:
+    FILE* watch_pipe = nullptr;
+    LineReader watch_lines;
+    std::unordered_map<std::string, int> client_counts;
+
+    // Applies a "<output> clients <n>" line and returns true if that count
+    // changed. Other lines (tags, titles, layouts) are ignored.
+    bool apply_line(std::string_view line) {
+        size_t space = line.find(' ');
+        if (space == 0 || space == std::string_view::npos) return false;
+        std::string_view output = line.substr(0, space);
+        std::string_view rest = line.substr(space + 1);
+        if (rest.rfind("clients ", 0) != 0) return false;
+        rest.remove_prefix(8);
+
+        int clients = 0;
+        auto parsed = std::from_chars(rest.data(), rest.data() + rest.size(), clients);
+        if (parsed.ec != std::errc()) return false;
+
+        auto it = client_counts.find(std::string(output));
+        if (it != client_counts.end() && it->second == clients) return false;
+        client_counts[std::string(output)] = clients;
+        return true;
+    }
+
 public:
-    bool is_layer_active(const std::string& layer_name) override {
-        FILE* pipe = popen("mmsg -g -e 2>/dev/null", "r");
-        if (!pipe) return false;
+    MangoBackend() {
+        FILE* pipe = popen("mmsg -g -t 2>/dev/null", "r");
+        if (!pipe) return;
         char buffer[128];
-        bool active = false;
         while (fgets(buffer, sizeof(buffer), pipe) != nullptr) {
-            std::string line(buffer);
-            if (line.find("last_layer " + layer_name) != std::string::npos) {
-                active = true;
-                break;
-            }
+            std::string_view line(buffer);
+            if (!line.empty() && line.back() == '\n') line.remove_suffix(1);
+            apply_line(line);
         }
         pclose(pipe);
-        return active;
     }
 
+    // Answered from the counts the watch stream keeps current.
     bool has_active_windows() override {
-        FILE* pipe = popen("mmsg -g -t 2>/dev/null", "r");
-        if (!pipe) return false;
-        char buffer[128];
-        bool has_windows = false;
-        while (fgets(buffer, sizeof(buffer), pipe) != nullptr) {
-            std::string line(buffer);
-            if (line.find("clients ") != std::string::npos) {
-                int clients = std::stoi(line.substr(line.find("clients ") + 8));
-                if (clients > 0) has_windows = true;
-            }
+        for (const auto& output : client_counts) {
+            if (output.second > 0) return true;
         }
-        pclose(pipe);
-        return has_windows;
+        return false;
     }
 
-    void listen_for_events(std::function<void()> on_event) override {
-        FILE* pipe = popen("mmsg -w -t -c 2>/dev/null", "r");
-        if (!pipe) return;
-        char buffer[128];
-        while (fgets(buffer, sizeof(buffer), pipe) != nullptr) {
-            on_event();
-        }
-        pclose(pipe);
+    bool listen_for_events(EventLoop& loop, std::function<void()> on_event) override {
+        watch_pipe = popen("mmsg -w -t -c 2>/dev/null", "r");
+        if (!watch_pipe) return false;
+        int fd = fileno(watch_pipe);
+        
+        // Read the pipe directly: stdio buffering would hide queued lines from epoll.
+        return loop.add_fd(fd, EPOLLIN, [this, &loop, fd, on_event](uint32_t) {
+            ssize_t bytes = watch_lines.fill(fd);
+            if (bytes > 0) {
+                bool changed = false;
+                std::string_view line;
+                while (watch_lines.next_line(line)) changed |= apply_line(line);
+                if (changed) on_event();
+                return;
+            }
+            if (bytes == -1 && errno == EINTR) return;
+            loop.remove_fd(fd);
+            pclose(watch_pipe);
+            watch_pipe = nullptr;
+            loop.stop();
+        });
     }
 };
 
+EventLoop event_loop;
+ProcessSupervisor waybar(event_loop, "waybar");
 bool is_waybar_visible = false;
-pid_t current_waybar_pid = -1;
 
 void set_waybar(bool visible) {
-    if (current_waybar_pid <= 0 || kill(current_waybar_pid, 0) != 0) {
-        current_waybar_pid = get_waybar_pid();
-    }
-
-    bool process_running = (current_waybar_pid > 0);
+    // A Waybar started elsewhere is only adopted at startup; one that exits
+    // is started again the next time the bar should show.
+    bool process_running = waybar.running();
     if (!process_running) is_waybar_visible = false;
 
     if (visible) {
         if (!process_running) {
-            pid_t pid = fork();
-            if (pid == 0) {
-                char* args[] = {(char*)"waybar", nullptr};
-                execvp(args[0], args);
-                exit(1); 
-            }
-            current_waybar_pid = pid;
-            is_waybar_visible = true;
+            if (waybar.spawn() > 0) is_waybar_visible = true;
         } else if (!is_waybar_visible) {
-            kill(current_waybar_pid, SIGUSR1);
+            waybar.signal(SIGUSR1);
             is_waybar_visible = true;
         }
     } else {
         if (process_running && is_waybar_visible) {
-            kill(current_waybar_pid, SIGUSR1);
+            waybar.signal(SIGUSR1);
             is_waybar_visible = false;
         }
     }
@@ -438,19 +548,24 @@ int main() {
         return 1;
     }
 
-    current_waybar_pid = get_waybar_pid();
-    if (current_waybar_pid > 0) {
-        is_waybar_visible = backend->is_layer_active("waybar");
-    } else {
-        is_waybar_visible = true; 
-    }
+    // A hidden Waybar keeps its layer mapped, so an adopted one cannot be
+    // told apart from a shown one. Both daemons show the bar when they exit,
+    // so it is taken as shown.
+    waybar.adopt();
+    is_waybar_visible = true; 
+
+    event_loop.add_signal(SIGTERM, []() { event_loop.stop(); });
+    event_loop.add_signal(SIGINT, []() { event_loop.stop(); });
 
     set_waybar(backend->has_active_windows());
 
-    backend->listen_for_events([&backend]() {
+    bool listening = backend->listen_for_events(event_loop, [&backend]() {
         bool has_windows = backend->has_active_windows();
         set_waybar(has_windows);
     });
+    if (!listening) return 1;
 
+    event_loop.run();
+    if (!is_waybar_visible && waybar.running()) waybar.signal(SIGUSR1);
     return 0;
 }
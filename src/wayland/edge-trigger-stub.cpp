@@ -0,0 +1,22 @@
+#include "edge-trigger.hpp"
+
+// Stands in for edge-trigger.cpp when the Wayland protocol tooling is not
+// installed. connect() always fails, so navbar-hover polls the cursor.
+
+EdgeTrigger::~EdgeTrigger() {}
+
+bool EdgeTrigger::connect(Edge, int, int) {
+    return false;
+}
+
+int EdgeTrigger::fd() const {
+    return -1;
+}
+
+bool EdgeTrigger::dispatch() {
+    return false;
+}
+
+void EdgeTrigger::set_bar_visible(bool) {}
+
+void EdgeTrigger::reconfigure(Edge, int, int) {}
@@ -0,0 +1,293 @@
+#include "edge-trigger.hpp"
+
+#include <algorithm>
+#include <string_view>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <wayland-client.h>
+
+// The protocol names a request argument "namespace".
+#define namespace namespace_
+#include "wlr-layer-shell-unstable-v1-client-protocol.h"
+#undef namespace
+
+namespace {
+
+// The strip past a visible bar is kept thick enough that a quick flick away
+// from the bar still lands a motion event inside it.
+const int MIN_GUARD_SIZE = 16;
+
+}
+
+struct EdgeTrigger::Listeners {
+    static void global(void* data, wl_registry* registry, uint32_t name, const char* interface, uint32_t version) {
+        EdgeTrigger* self = static_cast<EdgeTrigger*>(data);
+        std::string_view iface(interface);
+
+        if (iface == wl_compositor_interface.name) {
+            self->compositor = static_cast<wl_compositor*>(wl_registry_bind(registry, name, &wl_compositor_interface, std::min(version, 4u)));
+        } else if (iface == wl_shm_interface.name) {
+            self->shm = static_cast<wl_shm*>(wl_registry_bind(registry, name, &wl_shm_interface, 1));
+        } else if (iface == zwlr_layer_shell_v1_interface.name) {
+            self->layer_shell = static_cast<zwlr_layer_shell_v1*>(wl_registry_bind(registry, name, &zwlr_layer_shell_v1_interface, std::min(version, 3u)));
+        } else if (iface == wl_seat_interface.name && !self->seat) {
+            self->seat = static_cast<wl_seat*>(wl_registry_bind(registry, name, &wl_seat_interface, std::min(version, 5u)));
+            wl_seat_add_listener(self->seat, &seat_listener, self);
+        } else if (iface == wl_output_interface.name) {
+            auto strip = std::make_unique<Strip>();
+            strip->owner = self;
+            strip->name = name;
+            strip->output = static_cast<wl_output*>(wl_registry_bind(registry, name, &wl_output_interface, std::min(version, 3u)));
+            // Outputs announced before the initial roundtrip are set up by connect().
+            if (self->ready) self->create_surface(*strip);
+            self->strips.push_back(std::move(strip));
+        }
+    }
+
+    static void global_remove(void* data, wl_registry*, uint32_t name) {
+        EdgeTrigger* self = static_cast<EdgeTrigger*>(data);
+        auto it = std::find_if(self->strips.begin(), self->strips.end(), [name](const auto& strip) { return strip->name == name; });
+        if (it == self->strips.end()) return;
+
+        self->destroy_surface(**it);
+        if (wl_output_get_version((*it)->output) >= 3) wl_output_release((*it)->output);
+        else wl_output_destroy((*it)->output);
+        self->strips.erase(it);
+    }
+
+    static void seat_capabilities(void* data, wl_seat* seat, uint32_t capabilities) {
+        EdgeTrigger* self = static_cast<EdgeTrigger*>(data);
+        bool has_pointer = (capabilities & WL_SEAT_CAPABILITY_POINTER) != 0;
+
+        if (has_pointer && !self->pointer) {
+            self->pointer = wl_seat_get_pointer(seat);
+            wl_pointer_add_listener(self->pointer, &pointer_listener, self);
+        } else if (!has_pointer && self->pointer) {
+            if (wl_pointer_get_version(self->pointer) >= 3) wl_pointer_release(self->pointer);
+            else wl_pointer_destroy(self->pointer);
+            self->pointer = nullptr;
+        }
+    }
+
+    static void seat_name(void*, wl_seat*, const char*) {}
+
+    static void pointer_enter(void* data, wl_pointer*, uint32_t, wl_surface* surface, wl_fixed_t, wl_fixed_t) {
+        EdgeTrigger* self = static_cast<EdgeTrigger*>(data);
+        if (!surface) return;
+        for (const auto& strip : self->strips) {
+            if (strip->surface == surface) {
+                if (self->on_enter) self->on_enter();
+                return;
+            }
+        }
+    }
+
+    static void pointer_leave(void*, wl_pointer*, uint32_t, wl_surface*) {}
+    static void pointer_motion(void*, wl_pointer*, uint32_t, wl_fixed_t, wl_fixed_t) {}
+    static void pointer_button(void*, wl_pointer*, uint32_t, uint32_t, uint32_t, uint32_t) {}
+    static void pointer_axis(void*, wl_pointer*, uint32_t, uint32_t, wl_fixed_t) {}
+    static void pointer_frame(void*, wl_pointer*) {}
+    static void pointer_axis_source(void*, wl_pointer*, uint32_t) {}
+    static void pointer_axis_stop(void*, wl_pointer*, uint32_t, uint32_t) {}
+    static void pointer_axis_discrete(void*, wl_pointer*, uint32_t, int32_t) {}
+
+    static void layer_configure(void* data, zwlr_layer_surface_v1* layer_surface, uint32_t serial, uint32_t width, uint32_t height) {
+        Strip* strip = static_cast<Strip*>(data);
+        zwlr_layer_surface_v1_ack_configure(layer_surface, serial);
+        strip->owner->attach_buffer(*strip, width, height);
+        wl_surface_commit(strip->surface);
+    }
+
+    static void layer_closed(void* data, zwlr_layer_surface_v1*) {
+        Strip* strip = static_cast<Strip*>(data);
+        strip->owner->destroy_surface(*strip);
+    }
+
+    // Built field by field: newer wayland-client headers add events past the
+    // seat version bound here, which are never sent and stay null.
+    static wl_pointer_listener make_pointer_listener() {
+        wl_pointer_listener listener{};
+        listener.enter = pointer_enter;
+        listener.leave = pointer_leave;
+        listener.motion = pointer_motion;
+        listener.button = pointer_button;
+        listener.axis = pointer_axis;
+        listener.frame = pointer_frame;
+        listener.axis_source = pointer_axis_source;
+        listener.axis_stop = pointer_axis_stop;
+        listener.axis_discrete = pointer_axis_discrete;
+        return listener;
+    }
+
+    static const wl_registry_listener registry_listener;
+    static const wl_seat_listener seat_listener;
+    static const wl_pointer_listener pointer_listener;
+    static const zwlr_layer_surface_v1_listener layer_surface_listener;
+};
+
+const wl_registry_listener EdgeTrigger::Listeners::registry_listener = {global, global_remove};
+const wl_seat_listener EdgeTrigger::Listeners::seat_listener = {seat_capabilities, seat_name};
+const wl_pointer_listener EdgeTrigger::Listeners::pointer_listener = make_pointer_listener();
+const zwlr_layer_surface_v1_listener EdgeTrigger::Listeners::layer_surface_listener = {layer_configure, layer_closed};
+
+EdgeTrigger::~EdgeTrigger() {
+    for (auto& strip : strips) {
+        destroy_surface(*strip);
+        wl_output_destroy(strip->output);
+    }
+    if (pointer) wl_pointer_destroy(pointer);
+    if (seat) wl_seat_destroy(seat);
+    if (layer_shell) {
+        if (zwlr_layer_shell_v1_get_version(layer_shell) >= 3) zwlr_layer_shell_v1_destroy(layer_shell);
+        else wl_proxy_destroy(reinterpret_cast<wl_proxy*>(layer_shell));
+    }
+    if (shm) wl_shm_destroy(shm);
+    if (compositor) wl_compositor_destroy(compositor);
+    if (registry) wl_registry_destroy(registry);
+    if (display) wl_display_disconnect(display);
+}
+
+bool EdgeTrigger::connect(Edge bar_edge, int activate, int deactivate) {
+    edge = bar_edge;
+    activate_size = std::max(activate, 1);
+    deactivate_size = std::max(deactivate, 0);
+
+    display = wl_display_connect(nullptr);
+    if (!display) return false;
+
+    registry = wl_display_get_registry(display);
+    wl_registry_add_listener(registry, &Listeners::registry_listener, this);
+    if (wl_display_roundtrip(display) == -1) return false;
+    if (!compositor || !shm || !layer_shell) return false;
+
+    ready = true;
+    for (auto& strip : strips) create_surface(*strip);
+    flush();
+    return true;
+}
+
+int EdgeTrigger::fd() const {
+    return display ? wl_display_get_fd(display) : -1;
+}
+
+bool EdgeTrigger::dispatch() {
+    if (!display) return false;
+
+    while (wl_display_prepare_read(display) != 0) {
+        if (wl_display_dispatch_pending(display) == -1) return false;
+    }
+    if (wl_display_read_events(display) == -1) return false;
+    if (wl_display_dispatch_pending(display) == -1) return false;
+
+    flush();
+    return wl_display_get_error(display) == 0;
+}
+
+void EdgeTrigger::set_bar_visible(bool visible) {
+    if (visible == bar_visible) return;
+    bar_visible = visible;
+    place_all();
+}
+
+void EdgeTrigger::reconfigure(Edge bar_edge, int activate, int deactivate) {
+    edge = bar_edge;
+    activate_size = std::max(activate, 1);
+    deactivate_size = std::max(deactivate, 0);
+    place_all();
+}
+
+// New anchors and sizes take effect with the commit; the compositor answers
+// with a configure, which brings a buffer of the new size.
+void EdgeTrigger::place_all() {
+    for (auto& strip : strips) {
+        if (!strip->layer_surface) continue;
+        place(*strip);
+        wl_surface_commit(strip->surface);
+    }
+    flush();
+}
+
+void EdgeTrigger::flush() {
+    if (display) wl_display_flush(display);
+}
+
+void EdgeTrigger::create_surface(Strip& strip) {
+    strip.surface = wl_compositor_create_surface(compositor);
+    strip.layer_surface = zwlr_layer_shell_v1_get_layer_surface(layer_shell, strip.surface, strip.output, ZWLR_LAYER_SHELL_V1_LAYER_TOP, "navbar-hover");
+    zwlr_layer_surface_v1_add_listener(strip.layer_surface, &Listeners::layer_surface_listener, &strip);
+    zwlr_layer_surface_v1_set_exclusive_zone(strip.layer_surface, -1);
+    place(strip);
+    // The first commit carries no buffer; the buffer follows the configure.
+    wl_surface_commit(strip.surface);
+}
+
+void EdgeTrigger::destroy_surface(Strip& strip) {
+    if (strip.layer_surface) zwlr_layer_surface_v1_destroy(strip.layer_surface);
+    if (strip.surface) wl_surface_destroy(strip.surface);
+    if (strip.buffer) wl_buffer_destroy(strip.buffer);
+    strip.layer_surface = nullptr;
+    strip.surface = nullptr;
+    strip.buffer = nullptr;
+    strip.width = strip.height = 0;
+}
+
+// Anchors the strip to the bar edge and stretches it along that edge. With
+// the bar shown, a margin of deactivate_size pushes it just past the bar.
+void EdgeTrigger::place(Strip& strip) {
+    uint32_t thickness = bar_visible ? std::max(activate_size, MIN_GUARD_SIZE) : activate_size;
+    int offset = bar_visible ? deactivate_size : 0;
+
+    uint32_t anchor = 0;
+    int top = 0, right = 0, bottom = 0, left = 0;
+    switch (edge) {
+        case Edge::Top:
+            anchor = ZWLR_LAYER_SURFACE_V1_ANCHOR_TOP | ZWLR_LAYER_SURFACE_V1_ANCHOR_LEFT | ZWLR_LAYER_SURFACE_V1_ANCHOR_RIGHT;
+            top = offset;
+            break;
+        case Edge::Bottom:
+            anchor = ZWLR_LAYER_SURFACE_V1_ANCHOR_BOTTOM | ZWLR_LAYER_SURFACE_V1_ANCHOR_LEFT | ZWLR_LAYER_SURFACE_V1_ANCHOR_RIGHT;
+            bottom = offset;
+            break;
+        case Edge::Left:
+            anchor = ZWLR_LAYER_SURFACE_V1_ANCHOR_LEFT | ZWLR_LAYER_SURFACE_V1_ANCHOR_TOP | ZWLR_LAYER_SURFACE_V1_ANCHOR_BOTTOM;
+            left = offset;
+            break;
+        case Edge::Right:
+            anchor = ZWLR_LAYER_SURFACE_V1_ANCHOR_RIGHT | ZWLR_LAYER_SURFACE_V1_ANCHOR_TOP | ZWLR_LAYER_SURFACE_V1_ANCHOR_BOTTOM;
+            right = offset;
+            break;
+    }
+
+    bool horizontal = edge == Edge::Top || edge == Edge::Bottom;
+    zwlr_layer_surface_v1_set_anchor(strip.layer_surface, anchor);
+    zwlr_layer_surface_v1_set_size(strip.layer_surface, horizontal ? 0 : thickness, horizontal ? thickness : 0);
+    zwlr_layer_surface_v1_set_margin(strip.layer_surface, top, right, bottom, left);
+}
+
+// Attaches a fully transparent buffer of the configured size. The pixels are
+// never drawn: a fresh memfd reads back as zeros, which is transparent ARGB.
+void EdgeTrigger::attach_buffer(Strip& strip, uint32_t width, uint32_t height) {
+    if (width == 0 || height == 0) return;
+    if (strip.buffer && width == strip.width && height == strip.height) return;
+
+    int stride = static_cast<int>(width) * 4;
+    size_t size = static_cast<size_t>(stride) * height;
+    int fd = memfd_create("navbar-hover", MFD_CLOEXEC);
+    if (fd == -1) return;
+    if (ftruncate(fd, size) == -1) {
+        close(fd);
+        return;
+    }
+
+    wl_shm_pool* pool = wl_shm_create_pool(shm, fd, size);
+    wl_buffer* buffer = wl_shm_pool_create_buffer(pool, 0, width, height, stride, WL_SHM_FORMAT_ARGB8888);
+    wl_shm_pool_destroy(pool);
+    close(fd);
+
+    wl_surface_attach(strip.surface, buffer, 0, 0);
+    wl_surface_damage(strip.surface, 0, 0, width, height);
+    if (strip.buffer) wl_buffer_destroy(strip.buffer);
+    strip.buffer = buffer;
+    strip.width = width;
+    strip.height = height;
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+struct wl_display;
+struct wl_registry;
+struct wl_compositor;
+struct wl_shm;
+struct wl_seat;
+struct wl_pointer;
+struct wl_output;
+struct wl_surface;
+struct wl_buffer;
+struct zwlr_layer_shell_v1;
+struct zwlr_layer_surface_v1;
+
+// Hover trigger for an auto-hidden bar, built on wlr-layer-shell. A thin
+// transparent strip along the bar edge of every output reports the pointer
+// entering it, so revealing the bar needs no cursor polling. While the bar is
+// shown the strip sits just past the bar instead, and entering it means the
+// pointer has left. Either way the strip moves on as soon as it is entered.
+class EdgeTrigger {
+public:
+    enum class Edge { Top, Bottom, Left, Right };
+
+    EdgeTrigger() = default;
+    ~EdgeTrigger();
+    EdgeTrigger(const EdgeTrigger&) = delete;
+    EdgeTrigger& operator=(const EdgeTrigger&) = delete;
+
+    // Connects to $WAYLAND_DISPLAY and places a strip on every output. Returns
+    // false if there is no display or the compositor lacks layer-shell.
+    bool connect(Edge edge, int activate_size, int deactivate_size);
+
+    // Display fd to watch for EPOLLIN; call dispatch() whenever it is readable.
+    int fd() const;
+    // Handles pending events. Returns false once the connection is gone.
+    bool dispatch();
+
+    // Places the strips for the given bar state.
+    void set_bar_visible(bool visible);
+    // Moves the strips to a new edge and sizes, as after a config reload.
+    void reconfigure(Edge edge, int activate_size, int deactivate_size);
+
+    // Runs when the pointer enters a strip.
+    std::function<void()> on_enter;
+
+private:
+    struct Listeners;
+
+    struct Strip {
+        EdgeTrigger* owner = nullptr;
+        uint32_t name = 0;
+        wl_output* output = nullptr;
+        wl_surface* surface = nullptr;
+        zwlr_layer_surface_v1* layer_surface = nullptr;
+        wl_buffer* buffer = nullptr;
+        uint32_t width = 0;
+        uint32_t height = 0;
+    };
+
+    void create_surface(Strip& strip);
+    void destroy_surface(Strip& strip);
+    void place(Strip& strip);
+    void place_all();
+    void attach_buffer(Strip& strip, uint32_t width, uint32_t height);
+    void flush();
+
+    wl_display* display = nullptr;
+    wl_registry* registry = nullptr;
+    wl_compositor* compositor = nullptr;
+    wl_shm* shm = nullptr;
+    wl_seat* seat = nullptr;
+    wl_pointer* pointer = nullptr;
+    zwlr_layer_shell_v1* layer_shell = nullptr;
+    std::vector<std::unique_ptr<Strip>> strips;
+
+    bool ready = false;
+    bool bar_visible = true;
+    Edge edge = Edge::Top;
+    int activate_size = 10;
+    int deactivate_size = 40;
+};